@@ -0,0 +1,65 @@
+/**
+ * @file        tbinarymetric.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TBinaryMetric class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TBINARYMETRIC_H
+#define TBINARYMETRIC_H
+
+#include "timagemetric.h"
+
+#include <QVector>
+#include <QSize>
+
+/**
+ * @brief Binary image similarity metric over packed masks
+ *
+ * The rendered silhouette and the original binary radiograph are compared
+ * as packed masks, 64 pixels per word. Each word of the mask gives a value
+ * equal to the square root of the number of mismatching pixels, so the sum
+ * of the squared values equals the sum of squared differences of the
+ * binary images used by TSimpleMetric and TSimpleMetricMask. The pixels
+ * covered by the optional mask are excluded.
+ *
+ */
+class TBinaryMetric : public TImageMetric
+{
+public:
+    TBinaryMetric(TRenderer * renderer);
+    ~TBinaryMetric();
+
+    float * getValues();
+    float * getTargetValues();
+    int valuesCount() const;
+    void setImage(const QImage & image);
+    void setMask(const QImage & mask);
+    QSize getFrameSize() const;
+
+private:
+    static QVector<quint64> packImage(const QImage & image, bool covered);
+    void updateWords();
+
+    QSize myOriginalSize;
+    QVector<quint64> myRefBits;
+    QVector<quint64> myMaskBits;
+    QVector<quint64> myBits;
+    QVector<int> myWords;
+    QVector<float> myData;
+    QVector<float> myRefData;
+};
+
+#endif // TBINARYMETRIC_H
@@ -21,17 +21,25 @@
 #define TCPUNORMALIZEDMUTUALINFORMATIONMETRIC_H
 
 #include "timagemetric.h"
-#include "ssimrenderer.h"
 
 #include <QObject>
+#include <QVector>
 
 /**
- * @brief Wrapper for NMI metric computed using CPU
+ * @brief NMI metric computed by the CPU from the rendered red channel
+ *
+ * The joint histogram of large images is filled by the threads of the
+ * worker pool shared by the registration, see setWorkerPool(), each thread
+ * fills its own histogram of a range of rows and the histograms are merged
+ * at the end. The bins of four pixels are computed at once by SSE2
+ * when available. The rendered values can be spread between the two nearest
+ * bins by the partial volume interpolation, see setPartialVolume().
+ *
  */
 class TCPUNormalizedMutualInformationMetric : public TImageMetric
 {
 public:
-    TCPUNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TCPUNormalizedMutualInformationMetric(TRenderer * renderer);
     ~TCPUNormalizedMutualInformationMetric();
 
     int valuesCount() const;
@@ -39,9 +47,20 @@ public:
     float * getTargetValues();
     void setImage(const QImage & image);
     virtual void setHistogramBinsCount(int count);
+    void setPartialVolume(bool enable);
 
 private:
-    SSIMRenderer::NMIComputingCPU * nmiComputing;
+    void updateBins();
+    void fillHistogram(const float * data, int begin, int end, float * histogram) const;
+
+    /// Minimal number of pixels processed by a single thread
+    static const int MinPixelsPerThread = 65536;
+
+    QVector<float> myImage;
+    QVector<int> myImageBins;
+    QVector<QVector<float> > myHistograms;
+    int myBinsCount;
+    bool myPartialVolume;
     float myData;
     float myRefData;
 };
@@ -21,26 +21,53 @@
 #define TCPUSQUAREDDIFFERENCESMETRIC_H
 
 #include "timagemetric.h"
-#include "ssimrenderer.h"
+#include <QSize>
+#include <QRect>
 
 /**
- * @brief Wrapper for SSD metric computed using CPU
+ * @brief SSD metric computed by the CPU from the rendered red channel
+ *
+ * The sum of squared differences of the rendered image and the radiograph
+ * is computed over the crop rectangle, the pixels of the mask are ignored.
+ * Only the bounds of the rendered fragment are read back, the contribution
+ * of the remaining pixels is precomputed from the radiograph. The rows are
+ * summed four pixels at a time by SSE2 when available. The metric returns
+ * the square root of either the whole SSD or the partial sums of square
+ * tiles, see setTileSize(), so that the squared residuals sum up to the SSD.
+ *
  */
 class TCPUSquaredDifferencesMetric : public TImageMetric
 {
 public:
-    TCPUSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TCPUSquaredDifferencesMetric(TRenderer * renderer);
     ~TCPUSquaredDifferencesMetric();
 
     float * getValues();
     float * getTargetValues();
     int valuesCount() const;
     void setImage(const QImage & image);
+    void setMask(const QImage & mask);
+    void setTileSize(int size);
+    QSize getFrameSize() const;
 
 private:
-    SSIMRenderer::SSDComputingCPU * mySSDComputing;
-    float myData;
-    float myRefData;
+    QRect getRegion() const;
+    QSize getTilesCount() const;
+    void updateEnergies();
+    void resizeData();
+
+    QSize myOriginalSize;
+    float * myRefData;
+    QVector<quint64> myMaskBits;
+    int myMaskStride;
+    int myTileSize;
+
+    QRect myEnergyRegion;
+    QVector<double> myEnergies;
+
+    float * myData;
+    float * myTargetData;
+    int myN;
 };
 
-#endif // TGPUSQUAREDDIFFERENCESMETRIC_H
+#endif // TCPUSQUAREDDIFFERENCESMETRIC_H
@@ -23,17 +23,32 @@
 #include <QObject>
 #include <QVector>
 #include <QRect>
+#include <QSize>
 
 #include "ssimrenderer.h"
+#include "Renderer/trenderer.h"
 #include "Observer/tobserver.h"
 
+class TWorkerPool;
+
 /**
  * @brief Base class for metric wrappers
  */
 class TImageMetric
 {
 public:
-    TImageMetric(SSIMRenderer::OffscreenRenderer * renderer = NULL);
+    /**
+     * @brief Selection of the pixels providing the metric values
+     */
+    enum SamplingType
+    {
+        FullSampling,       ///< All the pixels
+        RandomSampling,     ///< Random subset, drawn again for each resample() call
+        StratifiedSampling, ///< Single random pixel from each of equally sized strata, drawn again for each resample() call
+        HaltonSampling      ///< Fixed low-discrepancy subset given by the Halton sequence
+    };
+
+    TImageMetric(TRenderer * renderer = NULL);
     ~TImageMetric();
 
     virtual float * getValues() = 0;
@@ -44,6 +59,17 @@ public:
     virtual void setMask(const QImage & mask);
     virtual void setHistogramBinsCount(int count);
 
+    virtual const int * getPixelIndices() const;
+    virtual QSize getFrameSize() const;
+
+    void setSampling(SamplingType type, int count, unsigned int seed = 0);
+    virtual void resample(unsigned int iteration);
+
+    inline SamplingType getSampling() const
+    {
+        return mySampling;
+    }
+
     inline void setCrop(QRect crop)
     {
         myCrop = crop;
@@ -54,10 +80,28 @@ public:
         myObserver = observer;
     }
 
+    /**
+     * @brief Sets the threads shared by the metrics of the registration
+     * @param pool Worker pool, the metric is computed by the calling thread only if null
+     */
+    inline void setWorkerPool(TWorkerPool * pool)
+    {
+        myWorkerPool = pool;
+    }
+
 protected:
+    QVector<int> selectSamples(const int * candidates, int n, unsigned int iteration) const;
+    static float normalizedMutualInformation(const float * histogram, int bins, int n);
+
+    SamplingType mySampling;
+    int mySampleCount;
+    unsigned int mySampleSeed;
+    unsigned int mySampleIteration;
+
     QRect myCrop;
-    SSIMRenderer::OffscreenRenderer * myRenderer;
+    TRenderer * myRenderer;
     TObserver * myObserver;
+    TWorkerPool * myWorkerPool;
 };
 
 #endif // TIMAGEMETRIC_H
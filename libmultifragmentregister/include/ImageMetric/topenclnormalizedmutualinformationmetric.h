@@ -35,7 +35,7 @@
 class TOpenCLNormalizedMutualInformationMetric : public TImageMetric
 {
 public:
-    TOpenCLNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TOpenCLNormalizedMutualInformationMetric(TRenderer * renderer);
     ~TOpenCLNormalizedMutualInformationMetric();
 
     int valuesCount() const;
@@ -33,7 +33,7 @@
 class TOpenCLSquaredDifferencesMetric : public TImageMetric
 {
 public:
-    TOpenCLSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TOpenCLSquaredDifferencesMetric(TRenderer * renderer);
     ~TOpenCLSquaredDifferencesMetric();
 
     float * getValues();
@@ -31,7 +31,7 @@
 class TOpenGLNormalizedMutualInformationMetric : public TImageMetric
 {
 public:
-    TOpenGLNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TOpenGLNormalizedMutualInformationMetric(TRenderer * renderer);
     ~TOpenGLNormalizedMutualInformationMetric();
 
     int valuesCount() const;
@@ -29,7 +29,7 @@
 class TOpenGLSquaredDifferencesMetric : public TImageMetric
 {
 public:
-    TOpenGLSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TOpenGLSquaredDifferencesMetric(TRenderer * renderer);
     ~TOpenGLSquaredDifferencesMetric();
 
     float * getValues();
@@ -29,20 +29,26 @@
 class TSimpleMetric : public TImageMetric
 {
 public:
-    TSimpleMetric(SSIMRenderer::OffscreenRenderer * renderer);
+    TSimpleMetric(TRenderer * renderer);
     ~TSimpleMetric();
 
     float * getValues();
     float * getTargetValues();
     int valuesCount() const;
     void setImage(const QImage & image);
+    const int * getPixelIndices() const;
+    QSize getFrameSize() const;
+    void resample(unsigned int iteration);
 
 private:
     QImage myImage;
     float * myData;
-    float * myOriginalData;
     float * myRefData;
+    float * myAllRefData;
+    int * myIndices;
+    int * myAllIndices;
     int myN;
+    int myAllN;
     QSize myOriginalSize;
 };
 
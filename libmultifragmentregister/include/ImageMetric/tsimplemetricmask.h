@@ -22,6 +22,8 @@
 
 #include "timagemetric.h"
 #include <QSize>
+#include <QPair>
+#include <QVector>
 
 /**
  * @brief Simple image similarity class metric
@@ -29,23 +31,32 @@
 class TSimpleMetricMask : public TImageMetric
 {
 public:
-    TSimpleMetricMask(SSIMRenderer::OffscreenRenderer * renderer);
+    TSimpleMetricMask(TRenderer * renderer);
     ~TSimpleMetricMask();
 
     float * getValues();
     float * getTargetValues();
     int valuesCount() const;
     void setImage(const QImage & image);
+    const int * getPixelIndices() const;
+    QSize getFrameSize() const;
+    void resample(unsigned int iteration);
     void setMask(const QImage & image);
 
 private:
+    void updateSpans();
+
     QImage myImage;
     QImage myMask;
     float * myData;
-    float * myOriginalData;
     float * myRefData;
+    float * myAllRefData;
+    int * myIndices;
+    int * myAllIndices;
     bool * myMaskData;
+    QVector<QPair<int, int> > mySpans;
     int myN;
+    int myAllN;
     QSize myOriginalSize;
 };
 
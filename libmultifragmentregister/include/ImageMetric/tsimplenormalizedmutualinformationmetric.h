@@ -0,0 +1,57 @@
+/**
+ * @file        tsimplenormalizedmutualinformationmetric.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TSimpleNormalizedMutualInformationMetric class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TSIMPLENORMALIZEDMUTUALINFORMATIONMETRIC_H
+#define TSIMPLENORMALIZEDMUTUALINFORMATIONMETRIC_H
+
+#include "timagemetric.h"
+
+#include <QVector>
+
+/**
+ * @brief NMI metric computed from the rendered image on the CPU
+ *
+ * Unlike the SSIMRenderer NMI wrappers the metric reads the rendered image
+ * through the renderer interface and works with any rendering backend.
+ *
+ */
+class TSimpleNormalizedMutualInformationMetric : public TImageMetric
+{
+public:
+    TSimpleNormalizedMutualInformationMetric(TRenderer * renderer);
+    ~TSimpleNormalizedMutualInformationMetric();
+
+    int valuesCount() const;
+    float * getValues();
+    float * getTargetValues();
+    void setImage(const QImage & image);
+    virtual void setHistogramBinsCount(int count);
+
+private:
+    void updateBins();
+
+    QVector<float> myImage;
+    QVector<int> myImageBins;
+    QVector<float> myHistogram;
+    int myBinsCount;
+    float myData;
+    float myRefData;
+};
+
+#endif // TSIMPLENORMALIZEDMUTUALINFORMATIONMETRIC_H
@@ -23,12 +23,18 @@
 #include "Observer/tobserver.h"
 #include <QObject>
 #include <QTime>
+#include <QMutex>
+#include <QThreadStorage>
 #include <QVector3D>
 #include <QImage>
 #include <QTextStream>
 
 /**
  * @brief Default registration observer class
+ *
+ * The rendering and metric notifications may come from several threads at
+ * once, e.g. from the asynchronous metrics or the parallel clones, each
+ * thread has its own timers and the accumulators are guarded by a mutex.
  */
 class TDefaultObserver : public TObserver
 {
@@ -70,6 +76,8 @@ public:
     inline double getMetricCount()      const { return myMetricsComputed; }
     inline double getTimePerRender()    const { return myRenderingTime / 1000.0 / myRenderedImages;  }
     inline double getTimePerMetric()    const { return myMetricTime    / 1000.0 / myMetricsComputed; }
+    inline const QList<int> & getRegistrationRenderedCounts()  const { return myRegistrationRenderedCounts; }
+    inline const QList<int> & getRegistrationIterations()      const { return myRegistrationIterations; }
 
 
 signals:
@@ -80,9 +88,10 @@ signals:
 protected:
     QTextStream * myStream;
 
-    QTime myRenderingTimer;
-    QTime myMetricTimer;
+    QThreadStorage<QTime> myRenderingTimer;
+    QThreadStorage<QTime> myMetricTimer;
     QTime myRegistrationTimer;
+    QMutex myMutex;
 
     int myRegistrationTime;
     int myRenderingTime;
@@ -95,6 +104,8 @@ protected:
 
     QList<float> myValues;
     int myIterations;
+    QList<int> myRegistrationRenderedCounts;
+    QList<int> myRegistrationIterations;
     QVector<QImage> myRefImages;
     QVector<QRect> myCrops;
 
@@ -24,6 +24,9 @@
 
 /**
  * @brief Base class for observer classes
+ *
+ * The rendering and metric notifications may be called concurrently by
+ * several threads, the derived classes have to be thread-safe there.
  */
 class TObserver : public QObject
 {
@@ -0,0 +1,62 @@
+/**
+ * @file        tworkerpool.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TWorkerPool class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TWORKERPOOL_H
+#define TWORKERPOOL_H
+
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include <functional>
+
+#include "Parallel/tworkerthread.h"
+
+/**
+ * @brief Set of worker threads shared by the data parallel jobs
+ *
+ * The pool splits a job into tasks executed by the calling thread and by
+ * the worker threads, which are started by the first job. Several threads
+ * may run their jobs at once, each of them waits only for its own tasks.
+ */
+class TWorkerPool
+{
+public:
+    explicit TWorkerPool(int count);
+    ~TWorkerPool();
+
+    void run(int count, const std::function<void(int)> & task);
+
+    /**
+     * @brief Gets the number of tasks executed at once, including the calling thread
+     * @return Number of threads
+     */
+    inline int size() const
+    {
+        return myCount + 1;
+    }
+
+private:
+    int myCount;
+    QMutex myMutex;
+    QAtomicInt myNext;
+    QVector<TWorkerThread *> myWorkers;
+};
+
+#endif // TWORKERPOOL_H
@@ -0,0 +1,60 @@
+/**
+ * @file        tworkerthread.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TWorkerThread class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TWORKERTHREAD_H
+#define TWORKERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+
+#include <functional>
+
+/**
+ * @brief Persistent worker thread executing queued jobs
+ *
+ * Every object created by a job lives in the worker thread, which is
+ * required by the offscreen renderers as their OpenGL contexts are bound
+ * to the thread they were created in. Jobs are executed in the order
+ * in which they were posted.
+ */
+class TWorkerThread : public QThread
+{
+public:
+    explicit TWorkerThread(QObject * parent = 0);
+    ~TWorkerThread();
+
+    void post(const std::function<void()> & job);
+    void waitForDone();
+    void execute(const std::function<void()> & job);
+
+protected:
+    void run();
+
+private:
+    QMutex myMutex;
+    QWaitCondition myJobPosted;
+    QWaitCondition myJobsDone;
+    QQueue<std::function<void()> > myJobs;
+    int myPending;
+    bool myStopped;
+};
+
+#endif // TWORKERTHREAD_H
@@ -0,0 +1,108 @@
+/**
+ * @file        tmodeldata.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TModelData class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TMODELDATA_H
+#define TMODELDATA_H
+
+#include <QVector>
+#include <QVector3D>
+
+#include "ssimrenderer.h"
+
+/**
+ * @brief Geometry and statistical shape model of the software renderer
+ *
+ * The class copies the mesh and the shape model out of the SSIMRenderer
+ * data structures and recomputes the vertices of the current shape as
+ * mean + sum(score * mode), a change of a few scores is applied
+ * incrementally, see setShapeParams(). The tetrahedra of the mesh share
+ * the vertices with the triangles, each of them has a constant density
+ * taken from the density model. All the SSIMRenderer data accessors used
+ * by the software renderer are concentrated in the implementation file.
+ *
+ */
+class TModelData
+{
+public:
+    TModelData();
+
+    void setMesh(SSIMRenderer::Mesh * mesh);
+    void setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile);
+    void setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile);
+
+    int getShapeParamsCount() const;
+    float getShapeParam(int i) const;
+    float getShapeStd(int i) const;
+    void setShapeParams(const QVector<float> & scores);
+
+    inline unsigned int getVersion() const
+    {
+        return myVersion;
+    }
+
+    inline int getNumberOfVertices() const
+    {
+        return myVertices.size();
+    }
+
+    inline const QVector<QVector3D> & getVertices() const
+    {
+        return myVertices;
+    }
+
+    inline const QVector<QVector<unsigned int> > & getTriangles() const
+    {
+        return myTriangles;
+    }
+
+    inline const QVector<QVector<unsigned int> > & getTetrahedra() const
+    {
+        return myTetrahedra;
+    }
+
+    inline const QVector<float> & getDensities() const
+    {
+        return myDensities;
+    }
+
+    inline SSIMRenderer::MatStatisticalDataFile * getDensityModel() const
+    {
+        return myDensityFile;
+    }
+
+private:
+    void updateVertices();
+    void updateDensities();
+
+    QVector<QVector3D> myMeanVertices;
+    QVector<QVector3D> myVertices;
+    QVector<QVector<unsigned int> > myTriangles;
+    QVector<QVector<unsigned int> > myTetrahedra;
+    QVector<float> myDensities;
+
+    QVector<float> myModes;
+    QVector<float> myStd;
+    QVector<float> myScores;
+
+    SSIMRenderer::MatStatisticalDataFile * myDensityFile;
+    int myUpdates;
+    unsigned int myVersion;
+};
+
+#endif // TMODELDATA_H
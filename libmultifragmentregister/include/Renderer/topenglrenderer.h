@@ -0,0 +1,99 @@
+/**
+ * @file        topenglrenderer.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TOpenGLRenderer class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TOPENGLRENDERER_H
+#define TOPENGLRENDERER_H
+
+#include "Renderer/trenderer.h"
+
+/**
+ * @brief Renderer using the SSIMRenderer OpenGL offscreen renderer
+ *
+ * The rendering modes of a new renderer are set explicitly to the same
+ * defaults as in TSoftwareRenderer, so that a renderer reused from the
+ * pool does not differ from a new one, see reset().
+ *
+ */
+class TOpenGLRenderer : public TRenderer
+{
+public:
+    explicit TOpenGLRenderer(TOpenGLRenderer * parent = NULL);
+    ~TOpenGLRenderer();
+
+    Backend getBackend() const;
+    SSIMRenderer::OffscreenRenderer * getOffscreenRenderer();
+    void reset();
+
+    void renderNow();
+    void getRenderedRedChannel(float *& data);
+    QImage getRenderedImage();
+    QSize getRenderedSize();
+
+    QVector<bool> getVerticesMask(const float * vertices, int nv);
+    QVector<bool> getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle);
+    int getRecomputedVertices(float *& vertices, bool transformed = false);
+    QVector<QVector3D> getRecomputedVertices(bool transformed);
+    int getNumberOfVertices();
+    QVector<QVector<unsigned int> > getTriangles();
+
+    void setRenderSize(int width, int height);
+    void setCropWindow(const QRect & crop);
+    QRect getCropWindow();
+    void setPerspective(const SSIMRenderer::Pyramid & perspective);
+
+    void setRotation(const QVector3D & rotation);
+    QVector3D getRotation();
+    void setTranslation(const QVector3D & translation);
+    QVector3D getTranslation();
+    QMatrix4x4 getTransformationMatrix();
+
+    void enableXMirroring(bool enable);
+    void enableDensity(bool enable);
+    void enableSilhouettes(bool enable);
+    void enablePolygonal(bool enable);
+    void enablePyramid(bool enable);
+    void enablePolygonalLighting(bool enable);
+    void setIntensity(float intensity);
+    void enableLogMessages(bool enable);
+
+    void setMesh(SSIMRenderer::Mesh * mesh, float * colors);
+    void setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile);
+    void setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile);
+
+    int getShapeParamsCount();
+    float getShapeParam(int i);
+    float getShapeStd(int i);
+    void setShapeParams(const QVector<float> & scores);
+    unsigned int getShapeVersion();
+
+    void exportSTL(const QString & fileName);
+    void exportSTL(const QString & fileName, bool transform);
+    void exportSTL(const QString & fileName, bool transform, const QVector<bool> & mask, int flags = 0);
+
+private:
+    void setDefaultModes();
+
+    TOpenGLRenderer * myRoot;
+    SSIMRenderer::OffscreenRenderer * myRenderer;
+    QSize mySize;
+    QRect myCrop;
+    unsigned int myShapeVersion;
+};
+
+#endif // TOPENGLRENDERER_H
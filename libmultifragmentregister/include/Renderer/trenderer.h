@@ -0,0 +1,156 @@
+/**
+ * @file        trenderer.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TRenderer class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TRENDERER_H
+#define TRENDERER_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QMatrix4x4>
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <functional>
+
+#include "ssimrenderer.h"
+
+class TWorkerPool;
+
+/**
+ * @brief Base class for virtual radiograph renderers
+ *
+ * The interface covers the part of SSIMRenderer::OffscreenRenderer used by
+ * the library. Renderers of the views sharing a parent renderer share its
+ * model, shape and pose, each view has its own perspective, size and crop.
+ *
+ * The rendered image can be read as a packed mask of the covered pixels,
+ * one bit per pixel, bit x % 64 of word x / 64 of the row. The rows are
+ * stored bottom-up as in the red channel, each of them padded to whole
+ * 64-bit words by zero bits.
+ *
+ * Renderers may report the bounds of the pixels covered by the model, the
+ * metrics then read back and evaluate only this region of the image, the
+ * pixels outside of it are zero.
+ *
+ */
+class TRenderer
+{
+public:
+    /**
+     * @brief Rendering backends
+     */
+    enum Backend
+    {
+        OpenGLBackend,  ///< SSIMRenderer::OffscreenRenderer
+        SoftwareBackend ///< CPU rasterizer, see TSoftwareRenderer
+    };
+
+    static TRenderer * create(Backend backend, TRenderer * parent = NULL);
+
+    TRenderer();
+    virtual ~TRenderer();
+
+    virtual Backend getBackend() const = 0;
+    virtual SSIMRenderer::OffscreenRenderer * getOffscreenRenderer();
+    virtual void reset() = 0;
+
+    virtual void renderNow() = 0;
+    virtual void renderPoses(const QVector<QVector3D> & rotations,
+                             const QVector<QVector3D> & translations,
+                             const QVector<TRenderer *> & views,
+                             const std::function<void(int, int)> & rendered,
+                             const std::function<void(int, int)> & rendering = std::function<void(int, int)>());
+    virtual void getRenderedRedChannel(float *& data) = 0;
+    virtual QImage getRenderedImage() = 0;
+    virtual QSize getRenderedSize() = 0;
+    virtual QRect getRenderedBounds();
+    virtual void getRenderedRegion(float * data, const QRect & region);
+    virtual const float * getRenderedRedChannelBuffer(int & stride);
+
+    virtual void enableBitMask(bool enable);
+    virtual void getRenderedBits(QVector<quint64> & bits);
+
+    virtual void setWorkerPool(TWorkerPool * pool);
+
+    /**
+     * @brief Gets the number of 64-bit words of a packed mask row
+     * @param width Width of the mask in pixels
+     * @return Number of words
+     */
+    static inline int getBitsStride(int width)
+    {
+        return (width + 63) / 64;
+    }
+
+    virtual QVector<bool> getVerticesMask(const float * vertices, int nv) = 0;
+    virtual QVector<bool> getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle) = 0;
+    virtual void getVerticesMasks(const float * vertices, int nv,
+                                  const QVector<TRenderer *> & views,
+                                  const QVector<QRectF> & crops,
+                                  const QVector<double> & angles,
+                                  QVector<QVector<quint64> > & masks);
+
+    static QVector<quint64> packMask(const QVector<bool> & mask);
+    static QVector<bool> unpackMask(const QVector<quint64> & bits, int n);
+    virtual int getRecomputedVertices(float *& vertices, bool transformed = false) = 0;
+    virtual QVector<QVector3D> getRecomputedVertices(bool transformed) = 0;
+    virtual int getNumberOfVertices() = 0;
+    virtual QVector<QVector<unsigned int> > getTriangles() = 0;
+
+    virtual void setRenderSize(int width, int height) = 0;
+    virtual void setCropWindow(const QRect & crop) = 0;
+    virtual QRect getCropWindow() = 0;
+    virtual void setPerspective(const SSIMRenderer::Pyramid & perspective) = 0;
+
+    virtual void setRotation(const QVector3D & rotation) = 0;
+    virtual QVector3D getRotation() = 0;
+    virtual void setTranslation(const QVector3D & translation) = 0;
+    virtual QVector3D getTranslation() = 0;
+    virtual QMatrix4x4 getTransformationMatrix() = 0;
+
+    virtual void enableXMirroring(bool enable) = 0;
+    virtual void enableDensity(bool enable) = 0;
+    virtual void enableSilhouettes(bool enable) = 0;
+    virtual void enablePolygonal(bool enable) = 0;
+    virtual void enablePyramid(bool enable) = 0;
+    virtual void enablePolygonalLighting(bool enable) = 0;
+    virtual void setIntensity(float intensity) = 0;
+    virtual void enableLogMessages(bool enable) = 0;
+
+    virtual void setMesh(SSIMRenderer::Mesh * mesh, float * colors) = 0;
+    virtual void setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile) = 0;
+    virtual void setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile) = 0;
+
+    virtual int getShapeParamsCount() = 0;
+    virtual float getShapeParam(int i) = 0;
+    virtual float getShapeStd(int i) = 0;
+    virtual void setShapeParams(const QVector<float> & scores) = 0;
+    virtual unsigned int getShapeVersion() = 0;
+
+    virtual void exportSTL(const QString & fileName) = 0;
+    virtual void exportSTL(const QString & fileName, bool transform) = 0;
+    virtual void exportSTL(const QString & fileName, bool transform, const QVector<bool> & mask, int flags = 0) = 0;
+
+private:
+    float * myReadback;
+};
+
+#endif // TRENDERER_H
@@ -0,0 +1,72 @@
+/**
+ * @file        trendererpool.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TRendererPool class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+
+#ifndef TRENDERERPOOL_H
+#define TRENDERERPOOL_H
+
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+
+#include "Renderer/trenderer.h"
+
+/**
+ * @brief Pool of renderers leased by the radiographs
+ *
+ * Creating an OpenGL renderer creates its context, surface and shaders,
+ * which dominates the startup of short registrations. With the pool
+ * enabled, the renderers released by the destroyed radiographs are kept
+ * and leased again to the radiographs of the next registration created
+ * in the same thread. A renderer created with a parent is only leased
+ * again with the same parent, so the renderers of a bone fragment are
+ * reused together.
+ *
+ * Released renderers are reset, see TRenderer::reset(), the pose, the crop
+ * and every rendering mode return to the defaults of a new renderer. The
+ * mesh, the models and the size are kept until the new owner sets them. The pool
+ * is disabled by default, the idle renderers of a thread have to be
+ * released by clear() before the thread or the application finishes.
+ *
+ */
+class TRendererPool
+{
+public:
+    static void setEnabled(bool enable);
+    static bool isEnabled();
+
+    static TRenderer * acquire(TRenderer::Backend backend, TRenderer * parent = NULL);
+    static void release(TRenderer * renderer);
+    static void clear();
+
+private:
+    /**
+     * @brief Pooled renderer
+     */
+    struct TEntry
+    {
+        TRenderer * parent;
+        QThread * thread;
+        bool leased;
+    };
+
+    static QMutex myMutex;
+    static bool myEnabled;
+    static QHash<TRenderer *, TEntry> myEntries;
+};
+
+#endif // TRENDERERPOOL_H
@@ -0,0 +1,203 @@
+/**
+ * @file        tsoftwarerenderer.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TSoftwareRenderer class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TSOFTWARERENDERER_H
+#define TSOFTWARERENDERER_H
+
+#include <QPointF>
+#include <QSize>
+
+#include "Renderer/trenderer.h"
+#include "Renderer/tmodeldata.h"
+#include "tprojection.h"
+
+/**
+ * @brief Headless renderer rasterizing the model on the CPU
+ *
+ * The renderer needs neither a GPU nor a display. The root renderer owns
+ * the model, the shape and the pose, the renderers created with a parent
+ * share them and keep their own perspective, size, crop and buffer.
+ *
+ * The polygonal model is rendered in white, silhouettes as white contour
+ * lines, optionally directly into a packed mask of the covered pixels,
+ * see enableBitMask(). The pose follows SSIMRenderer, see getModelMatrix(),
+ * LibMultiFragmentRegister::compareBackends() checks the agreement of both
+ * backends on the current scene. A batch of poses is transformed to
+ * the scene once per pose for all views, see renderPoses(). The
+ * rasterizer processes the triangles in 8x8 pixel tiles, whole tiles are
+ * accepted or rejected by the edge functions at their corners and
+ * partially covered tiles are tested four pixels at a time by SSE2
+ * instructions when available.
+ *
+ * Only the tiles inside the bounds of the projected vertices are cleared,
+ * integrated and read back, see getRenderedBounds().
+ *
+ * The density is rendered as a digitally reconstructed radiograph, the
+ * density of the tetrahedra is integrated along the ray of each pixel.
+ * The rows of the radiograph are split into bands integrated in parallel
+ * by the worker pool of the root renderer, the tetrahedra are binned to
+ * the bands overlapped by their bounds. Four neighbouring rays are clipped
+ * by the tetrahedron at once.
+ *
+ */
+class TSoftwareRenderer : public TRenderer
+{
+public:
+    explicit TSoftwareRenderer(TSoftwareRenderer * parent = NULL);
+    ~TSoftwareRenderer();
+
+    Backend getBackend() const;
+    void reset();
+
+    void renderNow();
+    void renderPoses(const QVector<QVector3D> & rotations,
+                     const QVector<QVector3D> & translations,
+                     const QVector<TRenderer *> & views,
+                     const std::function<void(int, int)> & rendered,
+                     const std::function<void(int, int)> & rendering = std::function<void(int, int)>());
+    void getRenderedRedChannel(float *& data);
+    QImage getRenderedImage();
+    QSize getRenderedSize();
+    QRect getRenderedBounds();
+    void getRenderedRegion(float * data, const QRect & region);
+    const float * getRenderedRedChannelBuffer(int & stride);
+
+    void enableBitMask(bool enable);
+    void getRenderedBits(QVector<quint64> & bits);
+
+    QVector<bool> getVerticesMask(const float * vertices, int nv);
+    QVector<bool> getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle);
+    void getVerticesMasks(const float * vertices, int nv,
+                          const QVector<TRenderer *> & views,
+                          const QVector<QRectF> & crops,
+                          const QVector<double> & angles,
+                          QVector<QVector<quint64> > & masks);
+    int getRecomputedVertices(float *& vertices, bool transformed = false);
+    QVector<QVector3D> getRecomputedVertices(bool transformed);
+    int getNumberOfVertices();
+    QVector<QVector<unsigned int> > getTriangles();
+
+    void setRenderSize(int width, int height);
+    void setCropWindow(const QRect & crop);
+    QRect getCropWindow();
+    void setPerspective(const SSIMRenderer::Pyramid & perspective);
+
+    void setRotation(const QVector3D & rotation);
+    QVector3D getRotation();
+    void setTranslation(const QVector3D & translation);
+    QVector3D getTranslation();
+    QMatrix4x4 getTransformationMatrix();
+
+    void enableXMirroring(bool enable);
+    void enableDensity(bool enable);
+    void enableSilhouettes(bool enable);
+    void enablePolygonal(bool enable);
+    void enablePyramid(bool enable);
+    void enablePolygonalLighting(bool enable);
+    void setIntensity(float intensity);
+    void enableLogMessages(bool enable);
+
+    void setMesh(SSIMRenderer::Mesh * mesh, float * colors);
+    void setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile);
+    void setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile);
+
+    int getShapeParamsCount();
+    float getShapeParam(int i);
+    float getShapeStd(int i);
+    void setShapeParams(const QVector<float> & scores);
+    unsigned int getShapeVersion();
+
+    void exportSTL(const QString & fileName);
+    void exportSTL(const QString & fileName, bool transform);
+    void exportSTL(const QString & fileName, bool transform, const QVector<bool> & mask, int flags = 0);
+
+    void setWorkerPool(TWorkerPool * pool);
+
+private:
+    /**
+     * @brief Tetrahedron prepared for the ray integration
+     *
+     * The ray of the buffer pixel (x, y) is eye + t * d(x, y). It is inside
+     * the tetrahedron if a[i] + t * (b[i] + x * bx[i] + y * by[i]) <= 0
+     * holds for all four faces.
+     *
+     */
+    struct TTetrahedron
+    {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+        float a[4];
+        float b[4];
+        float bx[4];
+        float by[4];
+        float density;
+    };
+
+    QMatrix4x4 getModelMatrix() const;
+    QVector<QVector3D> getSceneVertices() const;
+    void renderScene(const QVector<QVector3D> & scene);
+    QRect getCropRect() const;
+    QVector<QPointF> projectToBuffer(const QVector<QVector3D> & vertices) const;
+
+    void resizeBuffer();
+    QRect getBounds(const QVector<QPointF> & points) const;
+    void rasterizeTriangle(const QPointF & a, const QPointF & b, const QPointF & c, float value);
+    void fillTile(int x0, int y0, const float * edges, float value);
+    void rasterizeLine(const QPointF & a, const QPointF & b, float value);
+    void renderSilhouettes(const QVector<QVector3D> & scene, const QVector<QPointF> & points);
+    void renderDensity(const QVector<QVector3D> & scene, const QVector<QPointF> & points);
+    void integrateBand(int y0, int y1, const QVector3D & ray,
+                       const QVector<TTetrahedron> & tetrahedra, const QVector<int> & indices);
+
+    QVector<bool> getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle, bool cropped);
+    void maskVertices(const QMatrix4x4 & m, const QRectF & rect, const float * x, const float * y, const float * z, int n, quint64 * bits) const;
+
+    TSoftwareRenderer * myRoot;
+    TModelData * myModel;
+
+    QVector3D myRotation;
+    QVector3D myTranslation;
+    bool myMirroring;
+
+    QSize mySize;
+    QRect myCrop;
+    TProjection myProjection;
+
+    bool myDensity;
+    bool mySilhouettes;
+    bool myPolygonal;
+    bool myLighting;
+    float myIntensity;
+    bool myLogMessages;
+    bool myBitMask;
+    bool myBitsRendered;
+
+    QVector<float> myBuffer;
+    QVector<float> myRayLengths;
+    QVector<quint64> myBits;
+    int myStride;
+    int myBitsStride;
+    QRect myBounds;
+
+    TWorkerPool * myWorkerPool;
+};
+
+#endif // TSOFTWARERENDERER_H
@@ -0,0 +1,54 @@
+/**
+ * @file        tvertexbuffer.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TVertexBuffer class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+
+#ifndef TVERTEXBUFFER_H
+#define TVERTEXBUFFER_H
+
+#include <QVector>
+
+#include "Renderer/trenderer.h"
+
+/**
+ * @brief Vertices of the current shape of a bone fragment
+ *
+ * The buffer keeps the vertices of the renderer in the model coordinates
+ * and recomputes them only when the shape version of the renderer changes,
+ * see TRenderer::getShapeVersion(). The pose does not affect the model
+ * coordinates. The vertices are borrowed as an implicitly shared vector,
+ * a borrowed copy stays valid and unchanged when the buffer is recomputed.
+ *
+ */
+class TVertexBuffer
+{
+public:
+    explicit TVertexBuffer(TRenderer * renderer);
+
+    QVector<float> getVertices();
+    int getNumberOfVertices();
+    unsigned int getVersion();
+
+private:
+    void update();
+
+    TRenderer * myRenderer;
+    QVector<float> myVertices;
+    unsigned int myVersion;
+    bool myValid;
+};
+
+#endif // TVERTEXBUFFER_H
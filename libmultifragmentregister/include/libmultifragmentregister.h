@@ -25,9 +25,19 @@
 #include "tbonefragment.h"
 #include "VertexMetric/tvertexmetric.h"
 #include "Observer/tobserver.h"
+#include "Parallel/tworkerthread.h"
+#include "Parallel/tworkerpool.h"
+#include "tevaluationcache.h"
+#include "tscenesnapshot.h"
 
 #include <QObject>
 #include <QVector>
+#include <QMap>
+#include <QSharedPointer>
+#include <QThread>
+
+#include <random>
+#include <algorithm>
 
 #include <dlib/optimization.h>
 
@@ -43,12 +53,36 @@ public:
     void optimizePoseShape(unsigned int count = 0);
     void optimizePoseVertex();
     void optimizePoseShapeVertex(unsigned int count = 0);
+    void optimizeMultiResolution(unsigned int levels = 3, bool vertex = false,
+                                 const QVector<TStopCriteria> & criteria = QVector<TStopCriteria>(),
+                                 unsigned int starts = 1, double rotationRange = 5, double translationRange = 5,
+                                 unsigned int trialIterations = 5, unsigned int seed = 0);
+    void optimizePoseMultiStart(unsigned int starts, double rotationRange = 5, double translationRange = 5,
+                                unsigned int trialIterations = 5, unsigned int seed = 0);
+    void setResolutionLevel(unsigned int level);
+    unsigned int getResolutionLevel() const;
 
     QVector3D getBoundingBoxSize();
     QPair<QVector3D, QVector3D> getBoundingBox();
 
-    LibMultiFragmentRegister(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric);
-    static Pointer New(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric);
+    LibMultiFragmentRegister(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric,
+                             TRenderer::Backend backend = TRenderer::OpenGLBackend);
+    ~LibMultiFragmentRegister();
+    static Pointer New(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric,
+                       TRenderer::Backend backend = TRenderer::OpenGLBackend);
+
+    void setThreadsCount(unsigned int count);
+    void enableImagePoseGradient(bool enable);
+    void enableAsyncMetrics(bool enable);
+    void enableBroydenUpdates(bool enable, unsigned int refresh = 5, double minQuality = 0.25);
+    void setPixelSampling(TImageMetric::SamplingType type, int count, unsigned int seed = 0);
+    void setStopCriteria(const TStopCriteria & criteria);
+    TStopCriteria getStopCriteria() const;
+
+    TSceneSnapshot snapshot();
+    QVector<float> evaluate(const TSceneSnapshot & scene);
+    QVector<QVector<float> > evaluateAll(const QVector<TSceneSnapshot> & scenes);
+    dlib::matrix<float> evaluateJacobian(const TSceneSnapshot & scene, unsigned int shapeCount = 0);
 
     void setMeshModel(SSIMRenderer::Mesh * mesh);
     void enableDensity(  bool enable);
@@ -78,6 +112,7 @@ public:
     QVector<float> getVertexValues();
     QVector<float> getTargetVertexValues();
     QVector<float> getTargetValuesVertex();
+    QVector<float> getValuesVertex();
 
     QVector<float> getStandardizedShapeParams();
     QVector<float> getShapeParams();
@@ -106,6 +141,7 @@ public:
     void paramsChanged();
 
     QVector<QImage> getImages();
+    double compareBackends(TRenderer::Backend backend, double minOverlap = 0.95);
     TObserver * getObserver();
 
     void exportSingleStl(QString fileName);
@@ -122,11 +158,8 @@ public:
 
 private:
     void optimize(
-            sample_points (LibMultiFragmentRegister<MetricType>::*samples)(),
-            double (LibMultiFragmentRegister<MetricType>::*residuals_)(
-                const std::pair<input_vector, double>& data,
-                const parameter_vector& params
-                ),
+            QVector<float> (LibMultiFragmentRegister<MetricType>::*values_)(),
+            QVector<float> (LibMultiFragmentRegister<MetricType>::*targets_)(),
             dlib::matrix<float> (LibMultiFragmentRegister<MetricType>::*gradient_)(),
             parameter_vector (LibMultiFragmentRegister<MetricType>::*toVector_)(),
             void (LibMultiFragmentRegister<MetricType>::*fromVector_)(const parameter_vector & params),
@@ -139,16 +172,11 @@ private:
     void vectorToPoses(const parameter_vector & params);
     void vectorToPosesShape(const parameter_vector & params);
 
-    sample_points data_points();
-    sample_points data_points_vertex();
-
-    double getResidual(const std::pair<input_vector, double>& data,
-                       const parameter_vector& params);
-    double getResidualVertex(const std::pair<input_vector, double>& data,
-                             const parameter_vector& params);
-
-    parameter_vector getGradient(const std::pair<input_vector, double>& data,
-                                 const parameter_vector& params);
+    void getResiduals(const parameter_vector & params, dlib::matrix<double, 0, 1> & residuals);
+    const dlib::matrix<float> & getJacobian(const parameter_vector & params, dlib::matrix<double, 0, 1> & residuals);
+    void updateGradients(const parameter_vector & params);
+    QVector<QVector<bool> > storeMasks();
+    void restoreMasks(const QVector<QVector<bool> > & masks);
 
     dlib::matrix<float> poseGradient();
     dlib::matrix<float> poseShapeGradient();
@@ -165,20 +193,45 @@ private:
 
     void setShapeParamsCount(unsigned int count = 0);
 
+    enum GradientType
+    {
+        RotationGradient,
+        TranslationGradient,
+        ShapeGradient
+    };
+
+    dlib::matrix<float> fragmentGradient(int fragment, GradientType type, unsigned int count = 0);
+    dlib::matrix<float> parallelGradient(int fragment, GradientType type, unsigned int count);
+
+    void setupFrom(LibMultiFragmentRegister<MetricType> * registration);
+    void syncClones();
+    void updateClone(LibMultiFragmentRegister<MetricType> * clone, bool dirty);
+    void applySnapshot(const TSceneSnapshot & scene);
+    QVector<float> currentResiduals();
+    void deleteClones();
+    void settingsChanged();
+    void resamplePixels(unsigned int iteration);
+    void updateValuesCount();
+    double objectiveValue();
+    double fullObjectiveValue();
+
+    QSize levelSize(const QSize & size) const;
+    QRect levelRect(const QRect & rect) const;
+    QImage levelImage(int i);
+    QImage levelMask(int i);
+
     QVector<double> myAngles;
     int myValuesCount;
 
     dlib::matrix<float> (LibMultiFragmentRegister<MetricType>::*gradient)();
-    double (LibMultiFragmentRegister<MetricType>::*residuals)(
-            const std::pair<input_vector, double>& data,
-            const parameter_vector& params
-            );
+    QVector<float> (LibMultiFragmentRegister<MetricType>::*currentValues)();
+    QVector<float> (LibMultiFragmentRegister<MetricType>::*currentTargets)();
     parameter_vector (LibMultiFragmentRegister<MetricType>::*toVector)();
     void (LibMultiFragmentRegister<MetricType>::*fromVector)(const parameter_vector & params);
     void (LibMultiFragmentRegister<MetricType>::*myParamsChanged)();
 
     QVector<TBoneFragment<MetricType> *> myBoneFragments;
-    QVector<SSIMRenderer::OffscreenRenderer *> myRenderers;
+    QVector<TRenderer *> myRenderers;
     QVector<TXRayView<MetricType> *>  myXRayViews;
     QVector<MetricType *>  myMetrics;
 
@@ -193,6 +246,53 @@ private:
     TVertexMetric * myVertexMetric;
     QVector<QRectF> myOpenGLCrops;
     int myViewCount;
+    TRenderer::Backend myBackend;
+
+    // Settings replayed on the worker clones
+    SSIMRenderer::Mesh * myMesh;
+    SSIMRenderer::MatStatisticalDataFile * myShapeFile;
+    SSIMRenderer::MatStatisticalDataFile * myDensityFile;
+    QVector<SSIMRenderer::Pyramid> myPerspectives;
+    QVector<QSize>  mySizes;
+    QVector<QRect>  myCrops;
+    QVector<QImage> myImages;
+    QVector<QImage> myMasks;
+    QVector<int>    myBins;
+    double myPoseEps;
+    bool myDensity;
+    bool myDensitySet;
+    bool myMirroring;
+    bool myMirroringSet;
+
+    QVector<TWorkerThread *> myWorkers;
+    QVector<LibMultiFragmentRegister<MetricType> *> myClones;
+    QSharedPointer<TWorkerPool> myWorkerPool;
+    bool myClonesDirty;
+
+    bool myImagePoseGradient;
+
+    QVector<float> myTargets;
+    parameter_vector myValuesParams;
+
+    bool myBroyden;
+    unsigned int myBroydenRefresh;
+    unsigned int myBroydenAge;
+    double myBroydenMinQuality;
+    parameter_vector myLastParams;
+    dlib::matrix<float, 0, 1> myLastResiduals;
+
+    TEvaluationCache myCache;
+
+    TImageMetric::SamplingType mySampling;
+    int mySampleCount;
+    unsigned int mySampleSeed;
+    unsigned int mySampleIteration;
+
+    TStopCriteria myStopCriteria;
+
+    unsigned int myResolutionLevel;
+    QMap<unsigned int, QVector<QImage> > myLevelImages;
+    QMap<unsigned int, QVector<QImage> > myLevelMasks;
 };
 
 #include "libmultifragmentregister.hpp"
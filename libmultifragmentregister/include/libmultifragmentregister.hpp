@@ -24,6 +24,7 @@
 #include "VertexMetric/tsquareddifferencesvertexmetric.h"
 
 #include <QDebug>
+#include <QAtomicInt>
 #include <vector>
 #include <assert.h>
 
@@ -32,14 +33,15 @@
  * @param[in] FragmentCount Number of bone fragments
  * @param[in] ViewCount Number of radiographs per one bone fragment
  * @param[in] vertexMetric Pointer to the vertex metric object, can be null pointer
+ * @param[in] backend Rendering backend, the OpenGL and OpenCL metrics require the OpenGL backend
  * @return Pointer to created registration object
  */
 template <class MetricType>
 LibMultiFragmentRegister<MetricType> *
 LibMultiFragmentRegister<MetricType>::
-New(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric)
+New(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric, TRenderer::Backend backend)
 {
-    return new LibMultiFragmentRegister<MetricType>(FragmentCount, ViewCount, vertexMetric);
+    return new LibMultiFragmentRegister<MetricType>(FragmentCount, ViewCount, vertexMetric, backend);
 }
 
 /**
@@ -47,31 +49,734 @@ New(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric)
  * @param[in] FragmentCount Number of bone fragments
  * @param[in] ViewCount Number of radiographs per one bone fragment
  * @param[in] vertexMetric Pointer to the vertex metric object, can not be null pointer
+ * @param[in] backend Rendering backend, the OpenGL and OpenCL metrics require the OpenGL backend
  */
 template <class MetricType>
 LibMultiFragmentRegister<MetricType>::
-LibMultiFragmentRegister(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric):
+LibMultiFragmentRegister(int FragmentCount, int ViewCount, TVertexMetric * vertexMetric,
+                         TRenderer::Backend backend):
     LibMultiFragmentRegisterAbstract(FragmentCount, ViewCount, vertexMetric),
     myShapeParamsCount(0),
     myValuesCount(0),
     myObserver(0),
     myVertexMetric(vertexMetric),
-    myViewCount(ViewCount)
-{
+    myViewCount(ViewCount),
+    myBackend(backend),
+    myMesh(0),
+    myShapeFile(0),
+    myDensityFile(0),
+    myPoseEps(1.0),
+    myDensity(false),
+    myDensitySet(false),
+    myMirroring(false),
+    myMirroringSet(false),
+    myClonesDirty(true),
+    myImagePoseGradient(false),
+    myBroyden(false),
+    myBroydenRefresh(5),
+    myBroydenAge(0),
+    myBroydenMinQuality(0.25),
+    mySampling(TImageMetric::FullSampling),
+    mySampleCount(0),
+    mySampleSeed(0),
+    mySampleIteration(0),
+    myResolutionLevel(0)
+{
+    // The threads of the pool are started by the first metric or renderer needing them
+    myWorkerPool = QSharedPointer<TWorkerPool>(new TWorkerPool(QThread::idealThreadCount() - 1));
+
     assert(vertexMetric != NULL);
 
-    myVertexMetric->setViewsNumber(ViewCount);
-    myBoneFragments.clear();
-    myBoneFragments.resize(FragmentCount);
-    myRenderers.resize(0);
-    for(int i = 0; i < FragmentCount; i++)
+    myVertexMetric->setViewsNumber(ViewCount);
+    myBoneFragments.clear();
+    myBoneFragments.resize(FragmentCount);
+    myRenderers.resize(0);
+    for(int i = 0; i < FragmentCount; i++)
+    {
+        myBoneFragments[i] = new TBoneFragment<MetricType>(ViewCount, backend);
+        myRenderers += myBoneFragments[i]->getRenderers();
+        myMetrics   += myBoneFragments[i]->getMetrics();
+        myXRayViews += myBoneFragments[i]->getXRayViews();
+    }
+
+    foreach (MetricType * metric, myMetrics)
+        metric->setWorkerPool(myWorkerPool.data());
+    foreach (TRenderer * renderer, myRenderers)
+        renderer->setWorkerPool(myWorkerPool.data());
+    //enableDensity(true);
+}
+
+/**
+ * @brief Registration class destructor
+ */
+template <class MetricType>
+LibMultiFragmentRegister<MetricType>::
+~LibMultiFragmentRegister()
+{
+    deleteClones();
+    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+        delete boneFragment;
+}
+
+/**
+ * @brief Sets the number of threads evaluating the Jacobian matrix
+ * @param[in] count Number of worker threads, 0 disables the parallel evaluation
+ *
+ * Each worker thread owns a complete copy of the registration scene
+ * including its own renderers and metrics. The perturbed scenes needed
+ * by the central differences are distributed among the workers.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+setThreadsCount(unsigned int count)
+{
+    deleteClones();
+
+    const int fragmentCount = myBoneFragments.size();
+    const int viewCount = myViewCount;
+    const TRenderer::Backend backend = myBackend;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        // Renderers have to be created in the thread they will be used in
+        TWorkerThread * worker = new TWorkerThread;
+        LibMultiFragmentRegister<MetricType> * clone = NULL;
+        worker->execute([&clone, fragmentCount, viewCount, backend]() {
+            clone = new LibMultiFragmentRegister<MetricType>(fragmentCount, viewCount, new TSimpleVertexMetric, backend);
+        });
+        myWorkers.append(worker);
+        myClones.append(clone);
+    }
+    settingsChanged();
+}
+
+/**
+ * @brief Enables computing the pose Jacobian from the rendered image gradients
+ * @param[in] enable Boolean value
+ *
+ * Each radiograph is rendered once per Jacobian instead of twice per pose parameter.
+ * The mode is used only for metrics computing a value per pixel and only when
+ * the vertex metric is not involved, central differences are used otherwise.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+enableImagePoseGradient(bool enable)
+{
+    myImagePoseGradient = enable;
+}
+
+/**
+ * @brief Enables computing the metric of each radiograph while the next one is rendered
+ * @param[in] enable Boolean value
+ *
+ * Available for the software backend only, see TBoneFragment::enableAsyncMetrics().
+ * The worker clones keep the synchronous evaluation, they run in parallel already.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+enableAsyncMetrics(bool enable)
+{
+    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+        boneFragment->enableAsyncMetrics(enable);
+}
+
+/**
+ * @brief Enables Broyden updates of the Jacobian matrix between its full evaluations
+ * @param[in] enable Boolean value
+ * @param[in] refresh Number of Broyden updates after which the Jacobian is evaluated again
+ * @param[in] minQuality Minimal ratio of the actual and predicted decrease of the objective
+ *
+ * After each accepted step the Jacobian matrix J is corrected by the rank-1 update
+ * J += (dr - J dx) dx^T / (dx^T dx), where dx is the step and dr the change
+ * of the residuals. The finite differences Jacobian is computed again after
+ * the given number of updates or when the step quality falls below minQuality.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+enableBroydenUpdates(bool enable, unsigned int refresh, double minQuality)
+{
+    myBroyden = enable;
+    myBroydenRefresh = refresh;
+    myBroydenMinQuality = minQuality;
+}
+
+/**
+ * @brief Sets the selection of the radiograph pixels providing the metric values
+ * @param[in] type Sampling type
+ * @param[in] count Number of the selected pixels per radiograph, all the pixels are used if 0
+ * @param[in] seed Seed of the random and Halton sequences
+ *
+ * The random and stratified subsets are drawn again at the start of each
+ * optimization and stay fixed until it finishes, so that the residuals and
+ * Hessian accumulation scale with the sample size instead of the image size
+ * while all the objective values compared by the solver come from the same
+ * pixels. Metrics not computing a value per pixel ignore the setting.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+setPixelSampling(TImageMetric::SamplingType type, int count, unsigned int seed)
+{
+    mySampling = type;
+    mySampleCount = count;
+    mySampleSeed = seed;
+    mySampleIteration = 0;
+    settingsChanged();
+
+    foreach (MetricType * metric, myMetrics)
+        metric->setSampling(type, count, seed);
+    updateValuesCount();
+}
+
+/**
+ * @brief Computes the current value of the optimized objective
+ * @return Half of the sum of squared differences of the metric values and target values
+ */
+template <class MetricType>
+double LibMultiFragmentRegister<MetricType>::
+objectiveValue()
+{
+    const QVector<float> values = getValues();
+    double sum = 0;
+    for(int i = 0; i < values.size(); i++)
+    {
+        const double d = values.at(i) - myTargetValues.at(i);
+        sum += d * d;
+    }
+    return 0.5 * sum;
+}
+
+/**
+ * @brief Computes the objective value over all the radiograph pixels
+ * @return Half of the sum of squared differences of the metric values and target values
+ *
+ * The pixel sampling is bypassed and restored afterwards, so the value does not
+ * depend on the currently selected subset and can be compared between registrations.
+ *
+ */
+template <class MetricType>
+double LibMultiFragmentRegister<MetricType>::
+fullObjectiveValue()
+{
+    if(mySampling == TImageMetric::FullSampling || mySampleCount == 0)
+        return objectiveValue();
+
+    foreach (MetricType * metric, myMetrics)
+        metric->setSampling(TImageMetric::FullSampling, 0, mySampleSeed);
+    updateValuesCount();
+
+    const double value = objectiveValue();
+
+    foreach (MetricType * metric, myMetrics)
+    {
+        metric->setSampling(mySampling, mySampleCount, mySampleSeed);
+        metric->resample(mySampleIteration);
+    }
+    updateValuesCount();
+    return value;
+}
+
+/**
+ * @brief Sets the convergence criteria of the following optimizations
+ * @param[in] criteria Stop criteria
+ *
+ * The criteria can be changed between the registration stages,
+ * e.g. to stop the rough stages earlier.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+setStopCriteria(const TStopCriteria & criteria)
+{
+    myStopCriteria = criteria;
+}
+
+/**
+ * @brief Gets the convergence criteria
+ * @return Stop criteria
+ */
+template <class MetricType>
+TStopCriteria LibMultiFragmentRegister<MetricType>::
+getStopCriteria() const
+{
+    return myStopCriteria;
+}
+
+/**
+ * @brief Draws the given subset of the radiograph pixels
+ * @param[in] iteration Index of the subset, registrations drawing the same index select the same pixels
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+resamplePixels(unsigned int iteration)
+{
+    mySampleIteration = iteration;
+    foreach (MetricType * metric, myMetrics)
+        metric->resample(iteration);
+    updateValuesCount();
+}
+
+/**
+ * @brief Updates the number of the metric values and the target values
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+updateValuesCount()
+{
+    myValuesCount = 0;
+    foreach (MetricType * metric, myMetrics)
+        myValuesCount += metric->valuesCount();
+
+    foreach (TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+        boneFragment->initValuesCount();
+
+    myTargetValues = getTargetValues();
+}
+
+/**
+ * @brief Releases the worker threads together with their scenes
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+deleteClones()
+{
+    for(int i = 0; i < myWorkers.size(); i++)
+    {
+        LibMultiFragmentRegister<MetricType> * clone = myClones[i];
+        myWorkers[i]->execute([clone]() {
+            TSimpleVertexMetric * vertexMetric = static_cast<TSimpleVertexMetric *>(clone->myVertexMetric);
+            delete clone;
+            delete vertexMetric;
+            // The pooled renderers of the worker cannot outlive its thread
+            TRendererPool::clear();
+        });
+        delete myWorkers[i];
+    }
+    myWorkers.clear();
+    myClones.clear();
+}
+
+/**
+ * @brief Configures the registration to be the copy of another registration
+ * @param[in] registration Registration object providing the settings
+ *
+ * Pose and shape parameters are not copied, see syncClones(). The worker
+ * pool of the metrics and renderers is shared with the registration.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+setupFrom(LibMultiFragmentRegister<MetricType> * registration)
+{
+    myWorkerPool = registration->myWorkerPool;
+    foreach (MetricType * metric, myMetrics)
+        metric->setWorkerPool(myWorkerPool.data());
+    foreach (TRenderer * renderer, myRenderers)
+        renderer->setWorkerPool(myWorkerPool.data());
+
+    if(registration->myMesh != NULL)
+        setMeshModel(registration->myMesh);
+    if(registration->myDensityFile != NULL)
+        setDensityModel(registration->myDensityFile);
+    if(registration->myShapeFile != NULL)
+        setShapeModel(registration->myShapeFile);
+    if(registration->myMirroringSet)
+        enableMirroring(registration->myMirroring);
+    if(registration->myDensitySet)
+        enableDensity(registration->myDensity);
+    if(!registration->mySizes.isEmpty())
+        setSizes(registration->mySizes);
+    if(!registration->myOpenGLCrops.isEmpty())
+        setOpenGLCrops(registration->myOpenGLCrops);
+    if(!registration->myAngles.isEmpty())
+        setAngles(registration->myAngles);
+    if(!registration->myCrops.isEmpty())
+        setCrops(registration->myCrops);
+    if(registration->mySampling != TImageMetric::FullSampling)
+        setPixelSampling(registration->mySampling, registration->mySampleCount, registration->mySampleSeed);
+    if(!registration->myMasks.isEmpty())
+        setMasks(registration->myMasks);
+    if(!registration->myImages.isEmpty())
+        setImages(registration->myImages);
+    if(!registration->myPerspectives.isEmpty())
+        setPerspectives(registration->myPerspectives);
+    if(!registration->myBins.isEmpty())
+        setHistogramBinsCount(registration->myBins);
+    if(!registration->myPts.isEmpty())
+        setPoints(registration->myPts);
+    setPoseEps(registration->myPoseEps);
+    setResolutionLevel(registration->myResolutionLevel);
+}
+
+/**
+ * @brief Copies the current poses and shape into the scene of each worker
+ *
+ * The workers are reconfigured first if any setting was changed since
+ * the last synchronization.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+syncClones()
+{
+    const TSceneSnapshot scene = snapshot();
+    const bool dirty = myClonesDirty;
+
+    for(int i = 0; i < myWorkers.size(); i++)
+    {
+        LibMultiFragmentRegister<MetricType> * clone = myClones[i];
+        myWorkers[i]->post([this, clone, dirty, &scene]() {
+            updateClone(clone, dirty);
+            clone->applySnapshot(scene);
+        });
+    }
+
+    foreach(TWorkerThread * worker, myWorkers)
+        worker->waitForDone();
+
+    myClonesDirty = false;
+}
+
+/**
+ * @brief Brings the settings of a worker clone up to date, called in the thread of the clone
+ * @param[in] clone Worker clone
+ * @param[in] dirty Boolean value, configures the clone from scratch if true
+ *
+ * Otherwise only the resolution level is followed, which does nothing
+ * when the level is the same.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+updateClone(LibMultiFragmentRegister<MetricType> * clone, bool dirty)
+{
+    if(dirty)
+    {
+        clone->setupFrom(this);
+        clone->setObserver(myObserver);
+    }
+    else
+        clone->setResolutionLevel(myResolutionLevel);
+}
+
+/**
+ * @brief Gets the snapshot of the current parameters of the scene
+ * @return Poses, standardized shape and the pixel subset iteration
+ */
+template <class MetricType>
+TSceneSnapshot LibMultiFragmentRegister<MetricType>::
+snapshot()
+{
+    return TSceneSnapshot(getRotations(), getTranslations(), getStandardizedShapeParams(), mySampleIteration);
+}
+
+/**
+ * @brief Sets the parameters of the scene from the snapshot
+ * @param[in] scene Snapshot of the parameters
+ *
+ * Only the changed shape and pixel subset are applied, both are expensive.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+applySnapshot(const TSceneSnapshot & scene)
+{
+    if(mySampleIteration != scene.sampleIteration)
+        resamplePixels(scene.sampleIteration);
+    setRotations(scene.rotations);
+    setTranslations(scene.translations);
+    if(getStandardizedShapeParams() != scene.shape)
+        setStandardizedShapeParams(scene.shape);
+}
+
+/**
+ * @brief Renders the current scene and computes the residuals
+ * @return Differences of the metric values and the target values
+ */
+template <class MetricType>
+QVector<float> LibMultiFragmentRegister<MetricType>::
+currentResiduals()
+{
+    QVector<float> result = getValues();
+    for(int i = 0; i < result.size(); i++)
+        result[i] -= myTargetValues.at(i);
+    return result;
+}
+
+/**
+ * @brief Computes the residuals of the scene given by the snapshot
+ * @param[in] scene Snapshot of the parameters
+ * @return Differences of the metric values and the target values
+ *
+ * See evaluateAll().
+ *
+ */
+template <class MetricType>
+QVector<float> LibMultiFragmentRegister<MetricType>::
+evaluate(const TSceneSnapshot & scene)
+{
+    return evaluateAll(QVector<TSceneSnapshot>() << scene).first();
+}
+
+/**
+ * @brief Computes the residuals of the scenes given by the snapshots
+ * @param[in] scenes Snapshots of the parameters
+ * @return Differences of the metric values and the target values of each snapshot
+ *
+ * The snapshots are evaluated by the worker clones when the worker threads
+ * are enabled, see setThreadsCount(), the scene of this object is not
+ * touched then. Otherwise the snapshots are applied to this scene one
+ * after another and its parameters are restored afterwards, the rendered
+ * images are then those of the last snapshot and the shape is recomputed
+ * if it differs. In both cases neither the evaluation cache nor the masks
+ * of the visible vertices are changed, the vertex metric is not involved.
+ * The renders are reported to the observer by the scenes performing them.
+ *
+ */
+template <class MetricType>
+QVector<QVector<float> > LibMultiFragmentRegister<MetricType>::
+evaluateAll(const QVector<TSceneSnapshot> & scenes)
+{
+    const int taskCount = scenes.size();
+    QVector<QVector<float> > results(taskCount);
+
+    if(myWorkers.isEmpty())
+    {
+        const TSceneSnapshot current = snapshot();
+        for(int task = 0; task < taskCount; task++)
+        {
+            applySnapshot(scenes.at(task));
+            results[task] = currentResiduals();
+        }
+        applySnapshot(current);
+        return results;
+    }
+
+    const bool dirty = myClonesDirty;
+    QAtomicInt next(0);
+
+    for(int i = 0; i < myWorkers.size(); i++)
+    {
+        LibMultiFragmentRegister<MetricType> * clone = myClones[i];
+        myWorkers[i]->post([&, clone]() {
+            updateClone(clone, dirty);
+
+            int task;
+            while((task = next.fetchAndAddOrdered(1)) < taskCount)
+            {
+                clone->applySnapshot(scenes.at(task));
+                results[task] = clone->currentResiduals();
+            }
+        });
+    }
+
+    foreach(TWorkerThread * worker, myWorkers)
+        worker->waitForDone();
+
+    myClonesDirty = false;
+    return results;
+}
+
+/**
+ * @brief Computes the Jacobian matrix of the residuals in the scene given by the snapshot
+ * @param[in] scene Snapshot of the parameters
+ * @param[in] shapeCount Number of the leading shape parameters, only the poses are differentiated if 0
+ * @return Jacobian matrix approximated by central differences, one column per parameter
+ *
+ * The columns follow TSceneSnapshot::toParams(). All perturbed scenes are
+ * evaluated by a single evaluateAll() call.
+ *
+ */
+template <class MetricType>
+dlib::matrix<float> LibMultiFragmentRegister<MetricType>::
+evaluateJacobian(const TSceneSnapshot & scene, unsigned int shapeCount)
+{
+    const parameter_vector params = scene.toParams(shapeCount);
+    const int poseCount = 6 * myBoneFragments.size();
+    const int ParamCount = params.size();
+
+    // Plus and minus perturbation of each parameter
+    QVector<TSceneSnapshot> scenes;
+    QVector<float> eps(ParamCount);
+    for(int col = 0; col < ParamCount; col++)
+    {
+        eps[col] = (col < poseCount) ? myPoseEps : 1.0;
+
+        parameter_vector plus(params);
+        parameter_vector minus(params);
+
+         plus(col) += eps[col];
+        minus(col) -= eps[col];
+
+        scenes << scene.withParams(plus) << scene.withParams(minus);
+    }
+
+    const QVector<QVector<float> > residuals = evaluateAll(scenes);
+
+    const int valuesCount = residuals.isEmpty() ? 0 : residuals.first().size();
+    dlib::matrix<float> result(valuesCount, ParamCount);
+    for(int col = 0; col < ParamCount; col++)
+    {
+        const QVector<float> & plus  = residuals.at(2 * col);
+        const QVector<float> & minus = residuals.at(2 * col + 1);
+        for(int row = 0; row < valuesCount; row++)
+            result(row, col) = (plus.at(row) - minus.at(row)) / (2 * eps.at(col));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Marks the clones and the cached evaluations outdated after a change of settings
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+settingsChanged()
+{
+    myClonesDirty = true;
+    myCache.clear();
+}
+
+/**
+ * @brief Computes Jacobian matrix block of a single bone fragment
+ * @param[in] fragment Index of the bone fragment
+ * @param[in] type Type of the parameters
+ * @param[in] count Number of shape parameters, all parameters are used if 0
+ * @return Jacobian matrix approximated by central differences method
+ */
+template <class MetricType>
+dlib::matrix<float> LibMultiFragmentRegister<MetricType>::
+fragmentGradient(int fragment, GradientType type, unsigned int count)
+{
+    if(!myWorkers.isEmpty())
+        return parallelGradient(fragment, type, count);
+
+    TBoneFragment<MetricType> * boneFragment = myBoneFragments[fragment];
+    switch(type)
+    {
+    case RotationGradient:
+        return boneFragment->rotationGradient();
+    case TranslationGradient:
+        return boneFragment->translationGradient();
+    default:
+        return boneFragment->shapeGradient(count);
+    }
+}
+
+/**
+ * @brief Computes Jacobian matrix block of a single bone fragment using the worker threads
+ * @param[in] fragment Index of the bone fragment
+ * @param[in] type Type of the parameters
+ * @param[in] count Number of shape parameters, all parameters are used if 0
+ * @return Jacobian matrix approximated by central differences method
+ *
+ * Every perturbed scene is evaluated by the first idle worker. The results
+ * are stored per perturbation, so the matrix does not depend on scheduling.
+ * The masks of visible vertices and transformed points are stored in the same
+ * way as in the serial TBoneFragment::poseGradient and TBoneFragment::shapeGradient.
+ *
+ */
+template <class MetricType>
+dlib::matrix<float> LibMultiFragmentRegister<MetricType>::
+parallelGradient(int fragment, GradientType type, unsigned int count)
+{
+    syncClones();
+
+    TBoneFragment<MetricType> * boneFragment = myBoneFragments[fragment];
+    const int valuesCount = boneFragment->getValuesCount();
+    assert(valuesCount > 0);
+
+    const bool shapeType = type == ShapeGradient;
+    const QVector<float> shape = getStandardizedShapeParams();
+    const QVector3D pose = (type == RotationGradient) ? boneFragment->getRotation()
+                                                      : boneFragment->getTranslation();
+    const int ParamCount = shapeType ? (count == 0 ? shape.size() : count) : 3;
+    const float eps = shapeType ? 1.0 : myPoseEps;
+
+    // Plus and minus perturbation of each parameter
+    const int taskCount = 2 * ParamCount;
+    QVector<QVector<float> > values(taskCount, QVector<float>(valuesCount));
+    QVector<QVector<QVector<bool> > > masks(taskCount);
+    QVector<QVector<QVector3D> > points(taskCount);
+    QAtomicInt next(0);
+
+    for(int i = 0; i < myWorkers.size(); i++)
+    {
+        LibMultiFragmentRegister<MetricType> * clone = myClones[i];
+        myWorkers[i]->post([&, clone]() {
+            TBoneFragment<MetricType> * cloneFragment = clone->myBoneFragments[fragment];
+            int task;
+            while((task = next.fetchAndAddOrdered(1)) < taskCount)
+            {
+                const int col = task / 2;
+                const float delta = (task % 2 == 0) ? eps : -eps;
+                if(shapeType)
+                {
+                    QVector<float> s(shape);
+                    s[col] += delta;
+                    cloneFragment->setStandardizedShapeParams(s);
+                }
+                else
+                {
+                    QVector3D p(pose);
+                    p[col] += delta;
+                    if(type == RotationGradient)
+                        cloneFragment->setRotation(p);
+                    else
+                        cloneFragment->setTranslation(p);
+                }
+
+                cloneFragment->renderValues(values[task].data(), masks[task]);
+                points[task] = cloneFragment->getTransformedPoints();
+            }
+
+            if(shapeType)
+                cloneFragment->setStandardizedShapeParams(shape);
+            else if(type == RotationGradient)
+                cloneFragment->setRotation(pose);
+            else
+                cloneFragment->setTranslation(pose);
+        });
+    }
+
+    foreach(TWorkerThread * worker, myWorkers)
+        worker->waitForDone();
+
+    QVector<TXRayView<MetricType> *> XRayViews = boneFragment->getXRayViews();
+    for(int i = 0; i < XRayViews.size(); i++)
+        XRayViews[i]->resizeVertexMasks(ParamCount);
+
+    if(!shapeType)
     {
-        myBoneFragments[i] = new TBoneFragment<MetricType>(ViewCount);
-        myRenderers += myBoneFragments[i]->getRenderers();
-        myMetrics   += myBoneFragments[i]->getMetrics();
-        myXRayViews += myBoneFragments[i]->getXRayViews();
+        boneFragment->myPlusPoints.resize(ParamCount);
+        boneFragment->myMinusPoints.resize(ParamCount);
     }
-    //enableDensity(true);
+
+    dlib::matrix<float> result(valuesCount, ParamCount);
+    for(int col = 0; col < ParamCount; col++)
+    {
+        const QVector<float> & plus  = values.at(2 * col);
+        const QVector<float> & minus = values.at(2 * col + 1);
+        for(int row = 0; row < valuesCount; row++)
+            result(row, col) = (plus.at(row) - minus.at(row)) / (2 * eps);
+
+        for(int i = 0; i < XRayViews.size(); i++)
+        {
+            XRayViews[i]->myPlusMasks[col]  = masks.at(2 * col).at(i);
+            XRayViews[i]->myMinusMasks[col] = masks.at(2 * col + 1).at(i);
+        }
+
+        if(!shapeType)
+        {
+            boneFragment->myPlusPoints[col]  = points.at(2 * col);
+            boneFragment->myMinusPoints[col] = points.at(2 * col + 1);
+        }
+    }
+
+    return result;
 }
 
 /**
@@ -95,8 +800,8 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 optimizePoseVertex()
 {
-    optimize(&LibMultiFragmentRegister<MetricType>::data_points_vertex,
-             &LibMultiFragmentRegister<MetricType>::getResidualVertex,
+    optimize(&LibMultiFragmentRegister<MetricType>::getValuesVertex,
+             &LibMultiFragmentRegister<MetricType>::getTargetValuesVertex,
              &LibMultiFragmentRegister<MetricType>::poseGradientVertex,
              &LibMultiFragmentRegister<MetricType>::posesToVector,
              &LibMultiFragmentRegister<MetricType>::vectorToPoses,
@@ -116,8 +821,8 @@ void LibMultiFragmentRegister<MetricType>::
 optimizePoseShapeVertex(unsigned int count = 0)
 {
     setShapeParamsCount(count);
-    optimize(&LibMultiFragmentRegister<MetricType>::data_points_vertex,
-             &LibMultiFragmentRegister<MetricType>::getResidualVertex,
+    optimize(&LibMultiFragmentRegister<MetricType>::getValuesVertex,
+             &LibMultiFragmentRegister<MetricType>::getTargetValuesVertex,
              &LibMultiFragmentRegister<MetricType>::poseShapeGradientVertex,
              &LibMultiFragmentRegister<MetricType>::posesShapeToVector,
              &LibMultiFragmentRegister<MetricType>::vectorToPosesShape,
@@ -134,14 +839,136 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 optimizePose()
 {
-    optimize(&LibMultiFragmentRegister<MetricType>::data_points,
-             &LibMultiFragmentRegister<MetricType>::getResidual,
+    optimize(&LibMultiFragmentRegister<MetricType>::getValues,
+             &LibMultiFragmentRegister<MetricType>::getTargetValues,
              &LibMultiFragmentRegister<MetricType>::poseGradient,
              &LibMultiFragmentRegister<MetricType>::posesToVector,
              &LibMultiFragmentRegister<MetricType>::vectorToPoses,
              &LibMultiFragmentRegister<MetricType>::posesChanged);
 }
 
+/**
+ * @brief Performs rigid registration from several perturbed initial poses
+ * @param[in] starts Number of initial poses, the current pose is the first one
+ * @param[in] rotationRange Maximal perturbation of each rotation angle
+ * @param[in] translationRange Maximal perturbation of each translation coordinate
+ * @param[in] trialIterations Number of iterations between two comparisons of the candidates
+ * @param[in] seed Seed of the random perturbations
+ *
+ * Each initial pose is registered by its own registration object with its own
+ * renderers in its own thread. After each round of trialIterations iterations
+ * the worse half of the candidates is dropped, until a single candidate remains.
+ * The candidates are compared by their objective values over all the pixels,
+ * as their sampled subsets are not guaranteed to be the same.
+ * Its pose is then optimized by this object using the current stop criteria.
+ * Vertex metric is not involved.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+optimizePoseMultiStart(unsigned int starts, double rotationRange, double translationRange,
+                       unsigned int trialIterations, unsigned int seed)
+{
+    if(starts < 2)
+    {
+        optimizePose();
+        return;
+    }
+
+    const QVector<QVector3D> rotations    = getRotations();
+    const QVector<QVector3D> translations = getTranslations();
+    const QVector<float> shape = getStandardizedShapeParams();
+    const int fragmentCount = myBoneFragments.size();
+    const int viewCount = myViewCount;
+
+    TStopCriteria trial = myStopCriteria;
+    trial.maxIterations = trialIterations;
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+    QVector<TWorkerThread *> workers(starts);
+    QVector<LibMultiFragmentRegister<MetricType> *> candidates(starts, NULL);
+    QVector<double> objectives(starts, 0);
+
+    for(unsigned int i = 0; i < starts; i++)
+    {
+        QVector<QVector3D> r = rotations;
+        QVector<QVector3D> t = translations;
+        if(i > 0)
+        {
+            for(int f = 0; f < fragmentCount; f++)
+            {
+                r[f] += rotationRange    * QVector3D(unit(generator), unit(generator), unit(generator));
+                t[f] += translationRange * QVector3D(unit(generator), unit(generator), unit(generator));
+            }
+        }
+
+        // Renderers have to be created in the thread they will be used in
+        LibMultiFragmentRegister<MetricType> ** candidate = &candidates[i];
+        workers[i] = new TWorkerThread;
+        workers[i]->post([this, candidate, fragmentCount, viewCount, r, t, &shape, &trial]() {
+            *candidate = new LibMultiFragmentRegister<MetricType>(fragmentCount, viewCount, new TSimpleVertexMetric, myBackend);
+            (*candidate)->setupFrom(this);
+            (*candidate)->setStandardizedShapeParams(shape);
+            (*candidate)->setRotations(r);
+            (*candidate)->setTranslations(t);
+            (*candidate)->setStopCriteria(trial);
+        });
+    }
+
+    foreach(TWorkerThread * worker, workers)
+        worker->waitForDone();
+
+    QVector<int> alive;
+    for(unsigned int i = 0; i < starts; i++)
+        alive.append(i);
+
+    while(alive.size() > 1)
+    {
+        foreach(int i, alive)
+        {
+            LibMultiFragmentRegister<MetricType> * candidate = candidates[i];
+            double * objective = &objectives[i];
+            workers[i]->post([candidate, objective]() {
+                candidate->optimizePose();
+                *objective = candidate->fullObjectiveValue();
+            });
+        }
+
+        foreach(int i, alive)
+            workers[i]->waitForDone();
+
+        std::sort(alive.begin(), alive.end(), [&objectives](int a, int b) {
+            return objectives.at(a) < objectives.at(b);
+        });
+        alive.resize((alive.size() + 1) / 2);
+    }
+
+    QVector<QVector3D> bestRotations, bestTranslations;
+    LibMultiFragmentRegister<MetricType> * best = candidates[alive.first()];
+    workers[alive.first()]->execute([best, &bestRotations, &bestTranslations]() {
+        bestRotations    = best->getRotations();
+        bestTranslations = best->getTranslations();
+    });
+
+    for(unsigned int i = 0; i < starts; i++)
+    {
+        LibMultiFragmentRegister<MetricType> * candidate = candidates[i];
+        workers[i]->execute([candidate]() {
+            TSimpleVertexMetric * vertexMetric = static_cast<TSimpleVertexMetric *>(candidate->myVertexMetric);
+            delete candidate;
+            delete vertexMetric;
+            TRendererPool::clear();
+        });
+        delete workers[i];
+    }
+
+    setRotations(bestRotations);
+    setTranslations(bestTranslations);
+    optimizePose();
+}
+
 /**
  * @brief Performs non-rigid registration
  * @param[in] count Number of optimized shape model principal components
@@ -155,18 +982,206 @@ void LibMultiFragmentRegister<MetricType>::
 optimizePoseShape(unsigned int count = 0)
 {
     setShapeParamsCount(count);
-    optimize(&LibMultiFragmentRegister<MetricType>::data_points,
-             &LibMultiFragmentRegister<MetricType>::getResidual,
+    optimize(&LibMultiFragmentRegister<MetricType>::getValues,
+             &LibMultiFragmentRegister<MetricType>::getTargetValues,
              &LibMultiFragmentRegister<MetricType>::poseShapeGradient,
              &LibMultiFragmentRegister<MetricType>::posesShapeToVector,
              &LibMultiFragmentRegister<MetricType>::vectorToPosesShape,
              &LibMultiFragmentRegister<MetricType>::posesShapeChanged);
 }
 
+/**
+ * @brief Performs the pose and shape registration from coarse to fine resolution
+ * @param[in] levels Number of resolution levels
+ * @param[in] vertex Boolean value, involves the vertex metric in the shape stages if true
+ * @param[in] criteria Stop criteria of the stages, the current criteria are kept for the missing ones
+ * @param[in] starts Number of initial poses of the rigid stage, see optimizePoseMultiStart()
+ * @param[in] rotationRange Maximal perturbation of each rotation angle
+ * @param[in] translationRange Maximal perturbation of each translation coordinate
+ * @param[in] trialIterations Number of iterations between two comparisons of the candidates
+ * @param[in] seed Seed of the random perturbations
+ *
+ * The rigid registration, the registration of the first five principal
+ * components and the registration of all the principal components are
+ * performed. The rigid stage runs at the coarsest level, the five component
+ * stage halfway between it and the full resolution and the last stage
+ * always at the full resolution. The resolution halves with each level,
+ * three levels therefore run the first stages at 1/4 and 1/2 of the
+ * resolution, five levels at 1/16 and 1/4. Each stage starts from the
+ * parameters found by the previous one.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+optimizeMultiResolution(unsigned int levels, bool vertex, const QVector<TStopCriteria> & criteria,
+                        unsigned int starts, double rotationRange, double translationRange,
+                        unsigned int trialIterations, unsigned int seed)
+{
+    const int coarsest = levels > 0 ? levels - 1 : 0;
+
+    setResolutionLevel(coarsest);
+    if(criteria.size() > 0)
+        setStopCriteria(criteria.at(0));
+    optimizePoseMultiStart(starts, rotationRange, translationRange, trialIterations, seed);
+
+    setResolutionLevel(coarsest / 2);
+    if(criteria.size() > 1)
+        setStopCriteria(criteria.at(1));
+    if(vertex)
+        optimizePoseShapeVertex(5);
+    else
+        optimizePoseShape(5);
+
+    setResolutionLevel(0);
+    if(criteria.size() > 2)
+        setStopCriteria(criteria.at(2));
+    if(vertex)
+        optimizePoseShapeVertex();
+    else
+        optimizePoseShape();
+}
+
+/**
+ * @brief Sets the resolution of the rendered and target radiographs
+ * @param[in] level Resolution level, the resolution is divided by 2^level
+ *
+ * Render sizes, crops, target images and masks are scaled from the full
+ * resolution data provided to the setters. The scaled targets are computed
+ * once per level. Perspectives are not affected. The worker clones only
+ * switch their level on the next synchronization, they are not configured
+ * again from scratch.
+ *
+ */
+template <class MetricType>
+void LibMultiFragmentRegister<MetricType>::
+setResolutionLevel(unsigned int level)
+{
+    if(level == myResolutionLevel)
+        return;
+
+    myResolutionLevel = level;
+    myCache.clear();
+
+    int i = 0;
+    foreach (TXRayView<MetricType> * XRayView, myXRayViews)
+    {
+        if(!mySizes.isEmpty())
+            XRayView->setSize(levelSize(mySizes.at(i)));
+        if(!myCrops.isEmpty())
+            XRayView->setCrop(levelRect(myCrops.at(i)));
+        i++;
+    }
+
+    if(!myMasks.isEmpty())
+    {
+        i = 0;
+        foreach (MetricType * metric, myMetrics)
+            metric->setMask(levelMask(i++));
+    }
+
+    if(!myImages.isEmpty())
+    {
+        i = 0;
+        foreach (MetricType * metric, myMetrics)
+            metric->setImage(levelImage(i++));
+
+        updateValuesCount();
+        myTargetValuesVertex = getTargetValuesVertex();
+    }
+}
+
+/**
+ * @brief Gets the resolution level
+ * @return Resolution level, 0 stands for the full resolution
+ */
+template <class MetricType>
+unsigned int LibMultiFragmentRegister<MetricType>::
+getResolutionLevel() const
+{
+    return myResolutionLevel;
+}
+
+/**
+ * @brief Scales a size to the current resolution level
+ * @param[in] size Full resolution size
+ * @return Scaled size
+ */
+template <class MetricType>
+QSize LibMultiFragmentRegister<MetricType>::
+levelSize(const QSize & size) const
+{
+    const double f = 1 << myResolutionLevel;
+    return QSize(qMax(1, qRound(size.width()  / f)),
+                 qMax(1, qRound(size.height() / f)));
+}
+
+/**
+ * @brief Scales a rectangle to the current resolution level
+ * @param[in] rect Full resolution rectangle
+ * @return Scaled rectangle
+ */
+template <class MetricType>
+QRect LibMultiFragmentRegister<MetricType>::
+levelRect(const QRect & rect) const
+{
+    const double f = 1 << myResolutionLevel;
+    return QRect(QPoint(qRound(rect.x() / f), qRound(rect.y() / f)), levelSize(rect.size()));
+}
+
+/**
+ * @brief Gets the target image of a radiograph at the current resolution level
+ * @param[in] i Index of the radiograph
+ * @return Scaled target image of the size of the scaled crop
+ */
+template <class MetricType>
+QImage LibMultiFragmentRegister<MetricType>::
+levelImage(int i)
+{
+    if(myResolutionLevel == 0)
+        return myImages.at(i);
+
+    QVector<QImage> & images = myLevelImages[myResolutionLevel];
+    if(images.isEmpty())
+    {
+        images.resize(myImages.size());
+        for(int j = 0; j < myImages.size(); j++)
+        {
+            const QSize size = myCrops.isEmpty() ? levelSize(myImages.at(j).size()) : levelRect(myCrops.at(j)).size();
+            images[j] = myImages.at(j).scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    return images.at(i);
+}
+
+/**
+ * @brief Gets the mask of a radiograph at the current resolution level
+ * @param[in] i Index of the radiograph
+ * @return Scaled mask of the size of the scaled crop
+ */
+template <class MetricType>
+QImage LibMultiFragmentRegister<MetricType>::
+levelMask(int i)
+{
+    if(myResolutionLevel == 0)
+        return myMasks.at(i);
+
+    QVector<QImage> & masks = myLevelMasks[myResolutionLevel];
+    if(masks.isEmpty())
+    {
+        masks.resize(myMasks.size());
+        for(int j = 0; j < myMasks.size(); j++)
+        {
+            const QSize size = myCrops.isEmpty() ? levelSize(myMasks.at(j).size()) : levelRect(myCrops.at(j)).size();
+            masks[j] = myMasks.at(j).scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        }
+    }
+    return masks.at(i);
+}
+
 /**
  * @brief Optimizes image similarity and vertex metrics using Levenberg-Marquardt algorithm
- * @param[in] samples Function returning target values of involved metrics
- * @param[in] residuals Function returning differences between actual and target metrics values
+ * @param[in] values Function returning current values of involved metrics
+ * @param[in] targets Function returning target values of involved metrics
  * @param[in] gradient Function approximating Jacobian matrix
  * @param[in] fromVector Function adjusting the shape model according to the optimized values
  * @param[in] toVector Function converting the shape model parameters to the vector of optimized values
@@ -174,11 +1189,8 @@ optimizePoseShape(unsigned int count = 0)
 template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 optimize(
-    sample_points (LibMultiFragmentRegister<MetricType>::*samples)(),
-    double (LibMultiFragmentRegister<MetricType>::*residuals_)(
-            const std::pair<input_vector, double>& data,
-            const parameter_vector& params
-            ),
+    QVector<float> (LibMultiFragmentRegister<MetricType>::*values_)(),
+    QVector<float> (LibMultiFragmentRegister<MetricType>::*targets_)(),
     dlib::matrix<float> (LibMultiFragmentRegister<MetricType>::*gradient_)(),
     parameter_vector (LibMultiFragmentRegister<MetricType>::*toVector_)(),
     void (LibMultiFragmentRegister<MetricType>::*fromVector_)(const parameter_vector & params),
@@ -188,9 +1200,20 @@ optimize(
     toVector        = toVector_;
     fromVector      = fromVector_;
     gradient        = gradient_;
-    residuals       = residuals_;
+    currentValues   = values_;
+    currentTargets  = targets_;
     myParamsChanged = paramsChanged_;
 
+    assert(myValuesCount > 0);
+    if(mySampling == TImageMetric::RandomSampling || mySampling == TImageMetric::StratifiedSampling)
+        resamplePixels(mySampleIteration + 1);
+
+    myTargets = (this->*targets_)();
+    myValuesParams.set_size(0);
+    myLastResiduals.set_size(0);
+    myBroydenAge = 0;
+    myCache.clear();
+
     if(myObserver != NULL)
         myObserver->beforeRegistration();
 
@@ -198,18 +1221,18 @@ optimize(
 
     parameter_vector v = (this->*toVector)();
     typedef LibMultiFragmentRegister<MetricType> libmfr_type;
-    libmfr_solve_least_squares_lm(libmfr_objective_delta_stop_strategy<libmfr_type>(1e-7, 150, this),
-                           residuals, //&LibMultiFragmentRegister<MetricType>::getResidual,
-                           &LibMultiFragmentRegister<MetricType>::getGradient,
-                           (this->*samples)(), //data_points(),
+    libmfr_solve_least_squares_lm(libmfr_objective_delta_stop_strategy<libmfr_type>(myStopCriteria, this),
+                           &LibMultiFragmentRegister<MetricType>::getResiduals,
+                           &LibMultiFragmentRegister<MetricType>::getJacobian,
                            v,
                            this);
 
     if(myObserver != NULL)
         myObserver->afterRegistration();
 
-    //(this->*fromVector_)(v);
-    //getImages();
+    // The last evaluated point may be a rejected step, restore the solution
+    (this->*fromVector_)(v);
+    myCache.clear();
 }
 
 /**
@@ -273,6 +1296,7 @@ void LibMultiFragmentRegister<MetricType>::
 setPoints(const QVector<QVector3D> & points)
 {
     myPts = points;
+    settingsChanged();
     const int c = points.count() / myBoneFragments.count();
     int i = 0;
     foreach (TBoneFragment<MetricType> * boneFragment, myBoneFragments)
@@ -445,6 +1469,17 @@ getTargetValuesVertex()
     return result;
 }
 
+/**
+ * @brief Gets current values of image similarity metrics followed by values of the vertex metric
+ * @return Vector of metrics values
+ */
+template <class MetricType>
+QVector<float> LibMultiFragmentRegister<MetricType>::
+getValuesVertex()
+{
+    return getValues() + getVertexValues();
+}
+
 /**
  * @brief Gets pointer to the current registration observer
  * @return Pointer to observer
@@ -460,6 +1495,8 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setPoseEps(double eps)
 {
+    myPoseEps = eps;
+    settingsChanged();
     foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
         boneFragment->setPoseEps(eps);
 }
@@ -556,118 +1593,180 @@ vectorToPosesShape(const parameter_vector & params)
 }
 
 /**
- * Gets target values including the vertex metric
- * @return Metrics target values
+ * Gets differences between current and target metrics values
+ * @param[in] params Vector containing pose and/or shape parameters
+ * @param[out] residuals Vector of residuals
+ *
+ * The scene is set to the parameters even if the values are cached, the
+ * following evaluations and the observer expect the evaluated scene.
+ *
  */
 template <class MetricType>
-sample_points LibMultiFragmentRegister<MetricType>::
-data_points_vertex()
+void LibMultiFragmentRegister<MetricType>::
+getResiduals(const parameter_vector & params, dlib::matrix<double, 0, 1> & residuals)
 {
-    assert(myValuesCount > 0);
-    sample_points result;
-    input_vector input(1);
-    QVector<float> targetValues = getTargetValuesVertex();
+    (this->*fromVector)(params);
 
-    for(int i = 0; i < targetValues.count(); i++)
+    TEvaluationCache::Entry * entry = myCache.find(params);
+    if(entry != NULL && entry->hasValues)
     {
-        input(0) = i;
-        result.push_back(std::make_pair(input, targetValues.at(i)));
+        myValues = entry->values;
+        restoreMasks(entry->masks);
     }
+    else
+    {
+        myValues = (this->*currentValues)();
 
-    return result;
+        entry = myCache.insert(params);
+        if(entry != NULL)
+        {
+            entry->values = myValues;
+            entry->masks = storeMasks();
+            entry->hasValues = true;
+        }
+    }
+    myValuesParams = params;
+
+    const int n = myTargets.size();
+    const float * values  = myValues.constData();
+    const float * targets = myTargets.constData();
+
+    residuals.set_size(n);
+    for(int i = 0; i < n; i++)
+        residuals(i) = values[i] - targets[i];
 }
 
 /**
- * Gets target values of image similarity metrics
- * @return Similarity metrics target values
+ * Computes Jacobian matrix of the pose and (optionally) shape parameters
+ * @param[in] params Vector containing pose and (optionally) shape parameters
+ * @param[out] residuals Residuals in the same point, consistent with the Jacobian
+ * @return Jacobian matrix, one row per residual
  */
 template <class MetricType>
-sample_points LibMultiFragmentRegister<MetricType>::
-data_points()
+const dlib::matrix<float> & LibMultiFragmentRegister<MetricType>::
+getJacobian(const parameter_vector & params, dlib::matrix<double, 0, 1> & residuals)
 {
-    //qDebug() << "data_points" << getTargetValues().count() << myValuesCount;
-    assert(myValuesCount > 0);
-    sample_points result;
-    input_vector input(1);
-    QVector<float> targetValues = getTargetValues();
+    // Sets the scene to the parameters as well
+    getResiduals(params, residuals);
 
-    for(int i = 0; i < targetValues.count(); i++)
+    TEvaluationCache::Entry * entry = myCache.find(params);
+    if(entry != NULL && entry->hasJacobian)
     {
-        input(0) = i;
-        result.push_back(std::make_pair(input, targetValues.at(i)));
+        myGradients = entry->jacobian;
+        return myGradients;
     }
 
-    return result;
+    updateGradients(params);
+    myCache.storeJacobian(params, myGradients);
+    return myGradients;
 }
 
 /**
- * Gets differences between current and target image similarirty metrics values
- * @param[in] data Vector containing target values
- * @param[in] params Vector containing pose and/or shape parameters
- * @return Redidual scalar
+ * @brief Gets the vertices masks of all the radiographs
+ * @return Vector of masks, one per radiograph of each fragment
  */
 template <class MetricType>
-double LibMultiFragmentRegister<MetricType>::
-getResidual(const std::pair<input_vector, double>& data,
-            const parameter_vector& params)
+QVector<QVector<bool> > LibMultiFragmentRegister<MetricType>::
+storeMasks()
 {
-    //qDebug() << "getResidual";
-    int i = static_cast<int>(data.first(0));
-    if(i == 0)
+    QVector<QVector<bool> > masks;
+    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
     {
-        (this->*fromVector)(params);
-        myValues = getValues();
+        foreach(TXRayView<MetricType> * xRayView, boneFragment->getXRayViews())
+        {
+            masks.push_back(xRayView->getMask());
+        }
     }
-    //qDebug() << i << myValues.at(i) << data.second << myValues.at(i) - data.second;
-    return myValues.at(i) - data.second;
+    return masks;
 }
 
 /**
- * Gets differences between current and target vertex metrics values
- * @param[in] data Vector containing target values
- * @param[in] params Vector containing pose and/or shape parameters
- * @return Redidual scalar
+ * @brief Sets the vertices masks of all the radiographs
+ * @param[in] masks Vector of masks obtained by storeMasks()
  */
 template <class MetricType>
-double LibMultiFragmentRegister<MetricType>::
-getResidualVertex(const std::pair<input_vector, double>& data,
-            const parameter_vector& params)
+void LibMultiFragmentRegister<MetricType>::
+restoreMasks(const QVector<QVector<bool> > & masks)
 {
-    int i = static_cast<int>(data.first(0));
-    if(i == 0)
+    int i = 0;
+    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
     {
-        (this->*fromVector)(params);
-        myValues = getValues() + getVertexValues();
+        foreach(TXRayView<MetricType> * xRayView, boneFragment->getXRayViews())
+        {
+            if(i < masks.size())
+                xRayView->setMask(masks.at(i));
+            i++;
+        }
     }
-    return myValues.at(i) - data.second;
 }
 
 /**
- * Computes gradient of the pose and (optionally) shape parameters
- * @param[in] data Vector containing target values
+ * @brief Updates the Jacobian matrix for the given parameters
  * @param[in] params Vector containing pose and (optionally) shape parameters
- * @return Vector of partial derivatives
+ *
+ * The Jacobian is approximated by the gradient function unless the Broyden
+ * updates are enabled, see enableBroydenUpdates().
+ *
  */
 template <class MetricType>
-parameter_vector LibMultiFragmentRegister<MetricType>::
-getGradient(const std::pair<input_vector, double>& data,
-            const parameter_vector& params)
+void LibMultiFragmentRegister<MetricType>::
+updateGradients(const parameter_vector & params)
 {
-    //qDebug() << "getGradient";
-
-    int i = static_cast<int>(data.first(0));
-    if(i == 0)
+    if(!myBroyden)
     {
-        (this->*fromVector)(params);
         myGradients = (this->*gradient)();
+        return;
     }
 
-    parameter_vector result(myGradients.nc());
-    for(int j = 0; j < myGradients.nc(); j++)
-        result(j) = myGradients(i, j);
+    // Residuals in the current point, usually known from the accepted step
+    if(myValuesParams.size() != params.size() || myValuesParams != params)
+    {
+        myValues = (this->*currentValues)();
+        myValuesParams = params;
+    }
 
-    return result;
+    dlib::matrix<float, 0, 1> r(myTargets.size());
+    for(int i = 0; i < myTargets.size(); i++)
+        r(i) = myValues.at(i) - myTargets.at(i);
+
+    bool refresh = myBroydenAge >= myBroydenRefresh ||
+                   myLastResiduals.size() != r.size() ||
+                   myGradients.nr() != r.size() ||
+                   myGradients.nc() != params.size();
+
+    if(!refresh)
+    {
+        const dlib::matrix<float, 0, 1> dx = dlib::matrix_cast<float>(params - myLastParams);
+        const float dxNorm = dlib::dot(dx, dx);
+        if(dxNorm > 0)
+        {
+            const dlib::matrix<float, 0, 1> predicted = myLastResiduals + myGradients * dx;
+
+            // Ratio of the actual and predicted decrease of the objective
+            const double lastValue = dlib::dot(myLastResiduals, myLastResiduals);
+            const double predictedDecrease = lastValue - dlib::dot(predicted, predicted);
+            const double actualDecrease    = lastValue - dlib::dot(r, r);
+
+            if(predictedDecrease <= 0 || actualDecrease / predictedDecrease < myBroydenMinQuality)
+            {
+                refresh = true;
+            }
+            else
+            {
+                myGradients += (r - predicted) * dlib::trans(dx) / dxNorm;
+                myBroydenAge++;
+            }
+        }
+    }
+
+    if(refresh)
+    {
+        myGradients = (this->*gradient)();
+        myBroydenAge = 0;
+    }
 
+    myLastParams = params;
+    myLastResiduals = r;
 }
 
 /**
@@ -678,9 +1777,12 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setMasks(const QVector<QImage> & masks)
 {
+    myMasks = masks;
+    myLevelMasks.clear();
+    settingsChanged();
     unsigned int i = 0;
     foreach (MetricType * metric, myMetrics)
-        metric->setMask(masks.at(i++));
+        metric->setMask(levelMask(i++));
 }
 
 /**
@@ -691,18 +1793,14 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setImages(const QVector<QImage> & images)
 {
+    myImages = images;
+    myLevelImages.clear();
+    settingsChanged();
     unsigned int i = 0;
     foreach (MetricType * metric, myMetrics)
-        metric->setImage(images.at(i++));
+        metric->setImage(levelImage(i++));
 
-    myValuesCount = 0;
-    foreach (MetricType * metric, myMetrics)
-        myValuesCount += metric->valuesCount();
-
-    foreach (TBoneFragment<MetricType> * boneFragment, myBoneFragments)
-        boneFragment->initValuesCount();
-
-    myTargetValues = getTargetValues();
+    updateValuesCount();
     //qDebug() << myTargetValues.size();
     myTargetValuesVertex = getTargetValuesVertex();
 }
@@ -725,21 +1823,34 @@ poseGradient()
     unsigned int col = 0;
     unsigned int row = 0;
 
-    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+    for(int f = 0; f < myBoneFragments.size(); f++)
     {
+        TBoneFragment<MetricType> * boneFragment = myBoneFragments[f];
         int valuesCount = boneFragment->getValuesCount();
 
+        if(myImagePoseGradient && boneFragment->hasPixelValues())
+        {
+            dlib::set_subm(result,
+                  dlib::range(row, row + valuesCount - 1),
+                  dlib::range(col, col + 5)
+            ) = boneFragment->imagePoseGradient();
+
+            col += 6;
+            row += valuesCount;
+            continue;
+        }
+
         dlib::set_subm(result,
               dlib::range(row, row + valuesCount - 1),
               dlib::range(col, col + 2)
-        ) = boneFragment->rotationGradient();
+        ) = fragmentGradient(f, RotationGradient);
 
         col += 3;
 
         dlib::set_subm(result,
               dlib::range(row, row + valuesCount - 1),
               dlib::range(col, col + 2)
-        ) = boneFragment->translationGradient();
+        ) = fragmentGradient(f, TranslationGradient);
 
         col += 3;
         row += valuesCount;
@@ -772,14 +1883,15 @@ poseShapeGradient()
     ) = pose;
 
     unsigned int row = 0;
-    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+    for(int f = 0; f < myBoneFragments.size(); f++)
     {
+        TBoneFragment<MetricType> * boneFragment = myBoneFragments[f];
         int valuesCount = boneFragment->getValuesCount();
 
         dlib::set_subm(result,
               dlib::range(row, row + valuesCount - 1),
               dlib::range(pose.nc(), pose.nc() + myShapeParamsCount - 1)
-        ) = boneFragment->shapeGradient(myShapeParamsCount);
+        ) = fragmentGradient(f, ShapeGradient, myShapeParamsCount);
 
         row += valuesCount;
     }
@@ -807,26 +1919,18 @@ poseGradientVertex()
 
     // tady si vytvorit a ulozit masky...
     // ziskat pole vertexu
-    float * vertices = NULL;
-    myRenderers[0]->getRecomputedVertices(vertices);
-    const int nv = myRenderers[0]->getMesh()->getNumberOfVertices();
-    assert(vertices != NULL);
     // plus maska bude jina pro kazdej pohled, ale stejna pro kazdej param, navic stejna pro plus i minus
+    // Masks of all radiographs of a fragment are computed at once, the fragments share the shape
     QVector<QVector<bool> > mask;
-    mask.resize(myRenderers.size());
-    unsigned int i = 0;
-    foreach (SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
     {
-        QRectF crop = myXRayViews.at(i)->getOpenGLCrop();
-        double angle = myXRayViews.at(i)->getAngle();
-        mask[i] = renderer->getVerticesMask(vertices, nv, crop, angle);
-        i += 1;
+        QVector<QVector<bool> > fragmentMasks;
+        boneFragment->getVerticesMasks(fragmentMasks);
+        mask += fragmentMasks;
     }
 
-    delete[] vertices;
-
     QVector<QVector<QVector3D> > points(myBoneFragments.size());
-    i = 0;
+    unsigned int i = 0;
     foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
     {
         points[i] = boneFragment->getTransformedPoints();
@@ -835,8 +1939,9 @@ poseGradientVertex()
 
     // tzn. do plus masks i minus masks ulozit to samy
 
-    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+    for(int f = 0; f < myBoneFragments.size(); f++)
     {
+        TBoneFragment<MetricType> * boneFragment = myBoneFragments[f];
         int valuesCount = boneFragment->getValuesCount();
 
         // Vypocet gradientu rotace
@@ -872,7 +1977,7 @@ poseGradientVertex()
         dlib::set_subm(result,
               dlib::range(row, row + valuesCount - 1),
               dlib::range(col, col + 2)
-        ) = boneFragment->rotationGradient();
+        ) = fragmentGradient(f, RotationGradient);
 
         const int n = myXRayViews.size();
         const int ParamCount = 3;
@@ -910,7 +2015,7 @@ poseGradientVertex()
         dlib::set_subm(result,
               dlib::range(row, row + valuesCount - 1),
               dlib::range(col, col + 2)
-        ) = boneFragment->translationGradient();
+        ) = fragmentGradient(f, TranslationGradient);
 
         // Vypocet gradientu pro vertexovou metriku
         for(int p = 0; p < ParamCount; p++)
@@ -969,14 +2074,15 @@ poseShapeGradientVertex()
     ) = pose;
 
     unsigned int row = 0;
-    foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
+    for(int f = 0; f < myBoneFragments.size(); f++)
     {
+        TBoneFragment<MetricType> * boneFragment = myBoneFragments[f];
         int valuesCount = boneFragment->getValuesCount();
 
         dlib::set_subm(result,
               dlib::range(row, row + valuesCount - 1),
               dlib::range(pose.nc(), pose.nc() + myShapeParamsCount - 1)
-        ) = boneFragment->shapeGradient(myShapeParamsCount);
+        ) = fragmentGradient(f, ShapeGradient, myShapeParamsCount);
 
         row += valuesCount;
     }
@@ -1021,10 +2127,12 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setSizes(const QVector<QSize> & size)
 {
+    mySizes = size;
+    settingsChanged();
     int i = 0;
-    foreach (SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    foreach (TXRayView<MetricType> * XRayView, myXRayViews)
     {
-        renderer->setRenderSize(size.at(i).width(), size.at(i).height());
+        XRayView->setSize(levelSize(size.at(i)));
         i++;
     }
 }
@@ -1070,15 +2178,13 @@ template <class MetricType>
 QVector<float> LibMultiFragmentRegister<MetricType>::
 getValues()
 {
-    renderNow();
     unsigned int i = 0;
     float * data = new float[myValuesCount];
-    foreach (MetricType * metric, myMetrics)
+    foreach (TBoneFragment<MetricType> * boneFragment, myBoneFragments)
     {
-        const int n = metric->valuesCount();
-        float * values = metric->getValues();
-        memcpy((void*)(data + i), (void*)values, n * sizeof(float));
-        i += n;
+        boneFragment->renderValues(data + i);
+        foreach (MetricType * metric, boneFragment->getMetrics())
+            i += metric->valuesCount();
     }
 
     std::vector<float> vector;
@@ -1183,7 +2289,7 @@ QVector<QImage> LibMultiFragmentRegister<MetricType>::
 getImages()
 {
     QVector<QImage> result;
-    foreach(SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    foreach(TRenderer * renderer, myRenderers)
     {
         renderer->renderNow();
         result.append(renderer->getRenderedImage());
@@ -1191,6 +2297,71 @@ getImages()
     return result;
 }
 
+/**
+ * @brief Renders the current scene by another backend and compares the radiographs
+ * @param[in] backend Backend of the reference scene
+ * @param[in] minOverlap Lowest acceptable overlap of the covered pixels
+ * @return Lowest ratio of the intersection and the union of the covered pixels over the radiographs
+ *
+ * The reference scene is configured by setupFrom() in the calling thread,
+ * which has to be able to create the renderers of the backend. A warning is
+ * printed for each fragment whose transformation matrices differ and for
+ * each radiograph whose overlap is lower than minOverlap.
+ *
+ */
+template <class MetricType>
+double LibMultiFragmentRegister<MetricType>::
+compareBackends(TRenderer::Backend backend, double minOverlap)
+{
+    TSimpleVertexMetric vertexMetric;
+    LibMultiFragmentRegister<MetricType> reference(myBoneFragments.size(), myViewCount, &vertexMetric, backend);
+    reference.setupFrom(this);
+    reference.applySnapshot(snapshot());
+
+    const QVector<QMatrix4x4> transformations = getTransformations();
+    const QVector<QMatrix4x4> referenceTransformations = reference.getTransformations();
+    for(int i = 0; i < transformations.size(); i++)
+    {
+        if(!qFuzzyCompare(transformations.at(i), referenceTransformations.at(i)))
+            qDebug() << "WARNING: Transformation matrices of the fragment" << i << "differ between the backends";
+    }
+
+    const QVector<QImage> images = getImages();
+    const QVector<QImage> referenceImages = reference.getImages();
+    double result = 1.0;
+    for(int i = 0; i < images.size(); i++)
+    {
+        const QImage & image = images.at(i);
+        const QImage & referenceImage = referenceImages.at(i);
+        if(image.size() != referenceImage.size())
+        {
+            qDebug() << "WARNING: Radiograph" << i << "has different sizes in the backends";
+            result = 0.0;
+            continue;
+        }
+
+        int intersection = 0;
+        int united = 0;
+        for(int row = 0; row < image.height(); row++)
+        {
+            for(int col = 0; col < image.width(); col++)
+            {
+                const bool covered          = qRed(image.pixel(col, row)) > 0;
+                const bool referenceCovered = qRed(referenceImage.pixel(col, row)) > 0;
+                intersection += covered && referenceCovered;
+                united       += covered || referenceCovered;
+            }
+        }
+
+        const double overlap = (united > 0) ? double(intersection) / united : 1.0;
+        if(overlap < minOverlap)
+            qDebug() << "WARNING: Radiograph" << i << "overlaps by" << overlap << "between the backends";
+        result = qMin(result, overlap);
+    }
+
+    return result;
+}
+
 /**
  * @brief Renders images according to current shape and pose parameters
  */
@@ -1198,7 +2369,7 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 renderNow()
 {
-    foreach(SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    foreach(TRenderer * renderer, myRenderers)
     {
         if(myObserver != NULL)
             myObserver->beforeRendering();
@@ -1218,10 +2389,12 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setPerspectives(const QVector<SSIMRenderer::Pyramid> & perspectives)
 {
+    myPerspectives = perspectives;
+    settingsChanged();
     assert(perspectives.size() == myRenderers.size());
     unsigned int i = 0;
-    foreach(SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
-        renderer->setPerspective(perspectives.at(i++));
+    foreach(TXRayView<MetricType> * XRayView, myXRayViews)
+        XRayView->setPerspective(perspectives.at(i++));
 }
 
 /**
@@ -1232,6 +2405,9 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setMeshModel(SSIMRenderer::Mesh * mesh)
 {
+    myMesh = mesh;
+    settingsChanged();
+
     // Create array of white colors for polygonal model rendering
     int size = mesh->getNumberOfVertices() * 3;
     float * colors = new float[size]();
@@ -1239,7 +2415,7 @@ setMeshModel(SSIMRenderer::Mesh * mesh)
         colors[i] = 1.0;
 
     myVertexMetric->setMesh(mesh);
-    foreach(SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    foreach(TRenderer * renderer, myRenderers)
     {
         renderer->setMesh(mesh, colors);
     }
@@ -1253,6 +2429,8 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile)
 {
+    myShapeFile = shapeFile;
+    settingsChanged();
     foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
         boneFragment->setShapeModel(shapeFile);
 }
@@ -1265,6 +2443,8 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile)
 {
+    myDensityFile = densityFile;
+    settingsChanged();
     foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
         boneFragment->setDensityModel(densityFile);
 }
@@ -1328,7 +2508,10 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 enableMirroring(bool enable)
 {
-    foreach(SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    myMirroring = enable;
+    myMirroringSet = true;
+    settingsChanged();
+    foreach(TRenderer * renderer, myRenderers)
         renderer->enableXMirroring(enable);
 }
 
@@ -1340,7 +2523,10 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 enableDensity(bool enable)
 {
-    foreach(SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
+    myDensity = enable;
+    myDensitySet = true;
+    settingsChanged();
+    foreach(TRenderer * renderer, myRenderers)
     {
         renderer->enableDensity(enable);
         renderer->enableSilhouettes(false);
@@ -1361,7 +2547,9 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setObserver(TObserver * observer)
 {
+    // The clones report their renders and metrics to the same observer
     myObserver = observer;
+    myClonesDirty = true;
     foreach (TBoneFragment<MetricType> * boneFragment, myBoneFragments)
         boneFragment->setObserver(myObserver);
 }
@@ -1484,15 +2672,14 @@ exportEachStl(QString fileName, bool transform, bool crop, bool lengthFix,
 {
     QVector<QVector<bool> > msks(myBoneFragments.size());
     int i = 0;
-    const int n = myRenderers[0]->getMesh()->getNumberOfVertices();
+    const int n = myRenderers[0]->getNumberOfVertices();
     foreach(TBoneFragment<MetricType> * boneFragment, myBoneFragments)
     {
         // export proximalniho a distalniho fragmentu
         if(crop)
         {
-            float * v = NULL;            
-            boneFragment->getRenderers()[0]->getRecomputedVertices(v);
-            QVector<bool> msk = boneFragment->getRenderers()[0]->getVerticesMask(v, n, myOpenGLCrops.at(i*myViewCount), 0);
+            const QVector<float> v = boneFragment->getVertexBuffer()->getVertices();
+            QVector<bool> msk = boneFragment->getRenderers()[0]->getVerticesMask(v.constData(), n, myOpenGLCrops.at(i*myViewCount), 0);
 
 
 
@@ -1512,7 +2699,6 @@ exportEachStl(QString fileName, bool transform, bool crop, bool lengthFix,
             msks[i] = msk2;
 
             boneFragment->getRenderers()[0]->exportSTL(fileName + "." + QString::number(i) + ".stl", transform, msk2, 0);
-            delete v;
         }
         else
         {
@@ -1542,10 +2728,8 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 exportSTL(QString fileName)
 {
-    float * v = NULL;
-    const int n = myRenderers[0]->getMesh()->getNumberOfVertices();
-    myRenderers[0]->getRecomputedVertices(v);
-    QVector<bool> msk = myRenderers[0]->getVerticesMask(v, n);
+    const QVector<float> v = myBoneFragments[0]->getVertexBuffer()->getVertices();
+    QVector<bool> msk = myRenderers[0]->getVerticesMask(v.constData(), v.size() / 3);
 
     myRenderers[0]->exportSTL(fileName + ".stl", true, msk);
 }
@@ -1613,7 +2797,7 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 triangles(int *& triangles, int &nt)
 {
-    QVector<QVector<unsigned int>> result = myRenderers[0]->getMesh()->getTriangles2DVector();
+    QVector<QVector<unsigned int>> result = myRenderers[0]->getTriangles();
     nt = result.size() * 3;
     triangles = new int[nt];
     int k = 0;
@@ -1645,12 +2829,13 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setCrops(const QVector<QRect> & crops)
 {
+    myCrops = crops;
+    myLevelImages.clear();
+    myLevelMasks.clear();
+    settingsChanged();
     unsigned int i = 0;
-    foreach (SSIMRenderer::OffscreenRenderer * renderer, myRenderers)
-    {
-        QRect c = crops.at(i++);
-        renderer->setCropWindow(c);
-    }
+    foreach (TXRayView<MetricType> * XRayView, myXRayViews)
+        XRayView->setCrop(levelRect(crops.at(i++)));
         //metric->setCrop(crops.at(i++));
 
     //foreach (MetricType * metric, myMetrics)
@@ -1665,6 +2850,8 @@ template <class MetricType>
 void LibMultiFragmentRegister<MetricType>::
 setHistogramBinsCount(const QVector<int> & bins)
 {
+    myBins = bins;
+    settingsChanged();
     int i = 0;
     foreach (MetricType * metric, myMetrics)
     {
@@ -1682,6 +2869,7 @@ void LibMultiFragmentRegister<MetricType>::
 setOpenGLCrops(const QVector<QRectF> & crops)
 {
     myOpenGLCrops = crops;
+    settingsChanged();
     unsigned int i = 0;
     foreach (TXRayView<MetricType> * XRayView, myXRayViews)
         XRayView->setOpenGLCrop(crops.at(i++));
@@ -1696,6 +2884,7 @@ void LibMultiFragmentRegister<MetricType>::
 setAngles(const QVector<double> & angles)
 {
     myAngles = angles;
+    settingsChanged();
     unsigned int i = 0;
     foreach (TXRayView<MetricType> * XRayView, myXRayViews)
         XRayView->setAngle(angles.at(i++));
@@ -25,6 +25,8 @@
 #include "tbonefragment.h"
 #include "VertexMetric/tvertexmetric.h"
 #include "Observer/tobserver.h"
+#include "tstopcriteria.h"
+#include "tscenesnapshot.h"
 
 #include <QObject>
 #include <QVector>
@@ -44,7 +46,7 @@ class LibMultiFragmentRegisterAbstract
 {
 public:
     LibMultiFragmentRegisterAbstract() {}
-    ~LibMultiFragmentRegisterAbstract() {}
+    virtual ~LibMultiFragmentRegisterAbstract() {}
 
     QVector<QVector3D> myPts;
 
@@ -53,6 +55,14 @@ public:
     virtual void optimizePoseShape(unsigned int count = 0) = 0;
     virtual void optimizePoseVertex() = 0;
     virtual void optimizePoseShapeVertex(unsigned int count = 0) = 0;
+    virtual void optimizeMultiResolution(unsigned int levels = 3, bool vertex = false,
+                                         const QVector<TStopCriteria> & criteria = QVector<TStopCriteria>(),
+                                         unsigned int starts = 1, double rotationRange = 5, double translationRange = 5,
+                                         unsigned int trialIterations = 5, unsigned int seed = 0) = 0;
+    virtual void optimizePoseMultiStart(unsigned int starts, double rotationRange = 5, double translationRange = 5,
+                                        unsigned int trialIterations = 5, unsigned int seed = 0) = 0;
+    virtual void setResolutionLevel(unsigned int level) = 0;
+    virtual unsigned int getResolutionLevel() const = 0;
 
     virtual void renderNow() = 0;    
 
@@ -110,6 +120,18 @@ public:
     virtual void setAngles(const QVector<double> & angles) = 0;
     virtual void setSizes(const QVector<QSize> & sizes) = 0;
     virtual void setHistogramBinsCount(const QVector<int> & bins) = 0;
+    virtual void setThreadsCount(unsigned int count) = 0;
+    virtual void enableImagePoseGradient(bool enable) = 0;
+    virtual void enableAsyncMetrics(bool enable) = 0;
+    virtual void enableBroydenUpdates(bool enable, unsigned int refresh = 5, double minQuality = 0.25) = 0;
+    virtual void setPixelSampling(TImageMetric::SamplingType type, int count, unsigned int seed = 0) = 0;
+    virtual void setStopCriteria(const TStopCriteria & criteria) = 0;
+    virtual TStopCriteria getStopCriteria() const = 0;
+
+    virtual TSceneSnapshot snapshot() = 0;
+    virtual QVector<float> evaluate(const TSceneSnapshot & scene) = 0;
+    virtual QVector<QVector<float> > evaluateAll(const QVector<TSceneSnapshot> & scenes) = 0;
+    virtual dlib::matrix<float> evaluateJacobian(const TSceneSnapshot & scene, unsigned int shapeCount = 0) = 0;
 
     virtual void paramsChanged() = 0;
     static QVector<float> loadDataFromCSVFile(QString fileName);
@@ -118,6 +140,7 @@ public:
     static QRect cropImage(const QImage & image);
 
     virtual QVector<QImage> getImages() = 0;
+    virtual double compareBackends(TRenderer::Backend backend, double minOverlap = 0.95) = 0;
     virtual TObserver * getObserver() = 0;
 
     virtual void exportSingleStl(QString fileName) = 0;
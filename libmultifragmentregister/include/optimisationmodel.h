@@ -26,17 +26,26 @@
 #include <dlib/optimization/optimization_stop_strategies.h>
 
 #include "Observer/tobserver.h"
+#include "tstopcriteria.h"
+
+#include <QElapsedTimer>
 
 #include <QDebug>
+#include <algorithm>
 
 /**
  * @brief Optimisation model involving Levenberg-Marquardt algorithm
+ *
+ * The registration object provides the whole residual vector and the whole
+ * Jacobian matrix in one call. The gradient J^T r and the Gauss-Newton
+ * Hessian J^T J are accumulated from blocks of Jacobian rows, so that each
+ * block stays in cache while the matrix products are formed.
+ *
  */
 template <
     typename column_vector_type,
     typename funct_type,
     typename funct_der_type,
-    typename vector_type,
     typename libmfr_type
     >
 class libmfr_least_squares_lm_function_model
@@ -45,16 +54,13 @@ public:
     libmfr_least_squares_lm_function_model (
         const funct_type& f_,
         const funct_der_type& der_,
-        const vector_type& list_,
         libmfr_type *libmfr_
-    ) : f(f_), der(der_), list(list_), libmfr(libmfr_)
+    ) : f(f_), der(der_), libmfr(libmfr_)
     {
-        r.set_size(list.size(),1);
     }
 
     const funct_type& f;
     const funct_der_type& der;
-    const vector_type& list;
     libmfr_type *libmfr;
 
     typedef typename column_vector_type::type type;
@@ -65,23 +71,20 @@ public:
     typedef column_vector_type column_vector;
     typedef dlib::matrix<type,NR,NR,mem_manager_type,layout_type> general_matrix;
 
+    // Number of Jacobian rows processed at once
+    const static long block_size = 512;
+
     mutable dlib::matrix<type,0,1,mem_manager_type,layout_type> r;
-    mutable column_vector vtemp;
+    mutable column_vector rx;
 
     type operator() (
         const column_vector& x
     ) const
     {
-        type result = 0;
-        for (long i = 0; i < list.size(); ++i)
-        {
-            const type temp = (libmfr->*f)(list(i), x);
-            // save the residual for later
-            r(i) = temp;
-            result += temp*temp;
-        }
-
-        return 0.5*result;
+        (libmfr->*f)(x, r);
+        // save the point of the residuals for later
+        rx = x;
+        return 0.5*dlib::dot(r, r);
     }
 
     void get_derivative_and_hessian (
@@ -90,13 +93,30 @@ public:
         general_matrix& h
     ) const
     {
+        // The residuals are provided together with the Jacobian, the pixel
+        // subset stays fixed during the solve so they match the last evaluation
+        const dlib::matrix<float>& J = (libmfr->*der)(x, r);
+        rx = x;
+        DLIB_ASSERT(J.nr() == r.size() && J.nc() == x.size(),
+            "\t libmfr_least_squares_lm_function_model::get_derivative_and_hessian()"
+            << "\n\t Jacobian and residuals sizes do not match"
+            << "\n\t J.nr(): " << J.nr()
+            << "\n\t J.nc(): " << J.nc()
+            << "\n\t r.size(): " << r.size()
+            );
+
+        d.set_size(J.nc());
+        h.set_size(J.nc(), J.nc());
         d = 0;
         h = 0;
-        for (long i = 0; i < list.size(); ++i)
+
+        dlib::matrix<type> block;
+        for (long row = 0; row < J.nr(); row += block_size)
         {
-            vtemp = (libmfr->*der)(list(i), x);
-            d += r(i)*vtemp;
-            h += vtemp*trans(vtemp);
+            const long last = std::min(row + block_size, J.nr()) - 1;
+            block = dlib::matrix_cast<type>(dlib::rowm(J, dlib::range(row, last)));
+            h += dlib::trans(block)*block;
+            d += dlib::trans(block)*dlib::rowm(r, dlib::range(row, last));
         }
     }
 
@@ -108,17 +128,15 @@ template <
     typename column_vector_type,
     typename funct_type,
     typename funct_der_type,
-    typename vector_type,
     typename libmfr_type
     >
-libmfr_least_squares_lm_function_model<column_vector_type,funct_type,funct_der_type,vector_type,libmfr_type> libmfr_least_squares_lm_model (
+libmfr_least_squares_lm_function_model<column_vector_type,funct_type,funct_der_type,libmfr_type> libmfr_least_squares_lm_model (
     const funct_type& f,
     const funct_der_type& der,
-    const vector_type& list,
     libmfr_type *libmfr
 )
 {
-    return libmfr_least_squares_lm_function_model<column_vector_type,funct_type,funct_der_type,vector_type,libmfr_type>(f,der,list,libmfr);
+    return libmfr_least_squares_lm_function_model<column_vector_type,funct_type,funct_der_type,libmfr_type>(f,der,libmfr);
 }
 
 // ----------------------------------------------------------------------------------------
@@ -127,7 +145,6 @@ template <
     typename stop_strategy_type,
     typename funct_type,
     typename funct_der_type,
-    typename vector_type,
     typename T,
     typename libmfr_type
     >
@@ -135,7 +152,6 @@ double libmfr_solve_least_squares_lm (
     stop_strategy_type stop_strategy,
     const funct_type& f,
     const funct_der_type& der,
-    const vector_type& list,
     T& x,
     libmfr_type *libmfr,
     double radius = 1
@@ -145,18 +161,15 @@ double libmfr_solve_least_squares_lm (
     COMPILE_TIME_ASSERT(T::NC <= 1);
 
     // make sure requires clause is not broken
-    DLIB_ASSERT(is_vector(mat(list)) && list.size() > 0 &&
-                is_col_vector(x) && radius > 0,
+    DLIB_ASSERT(is_col_vector(x) && radius > 0,
         "\t double solve_least_squares_lm()"
         << "\n\t invalid arguments were given to this function"
-        << "\n\t is_vector(list):  " << is_vector(mat(list))
-        << "\n\t list.size():      " << list.size()
         << "\n\t is_col_vector(x): " << is_col_vector(x)
         << "\n\t radius:           " << radius
         );
 
     return dlib::find_min_trust_region(stop_strategy,
-                                       libmfr_least_squares_lm_model<T>(f, der, mat(list), libmfr),
+                                       libmfr_least_squares_lm_model<T>(f, der, libmfr),
                                        x,
                                        radius);
 }
@@ -165,6 +178,9 @@ double libmfr_solve_least_squares_lm (
 
 /**
  * @brief Stop strategy for the optimisation model
+ *
+ * Stops the search according to TStopCriteria, see its description.
+ *
  */
 template <typename libmfr_type>
 class libmfr_objective_delta_stop_strategy
@@ -172,7 +188,7 @@ class libmfr_objective_delta_stop_strategy
 public:
     explicit libmfr_objective_delta_stop_strategy (
         double min_delta = 1e-7
-    ) : _verbose(false), _been_used(false), _min_delta(min_delta), _max_iter(0), _cur_iter(0), _prev_funct_value(0)
+    ) : _verbose(false), _been_used(false), _criteria(min_delta, 0), _cur_iter(0), _prev_funct_value(0), _libmfr(0)
     {
         DLIB_ASSERT (
             min_delta >= 0,
@@ -186,7 +202,7 @@ public:
         double min_delta,
         unsigned long max_iter,
         libmfr_type *libmfr
-    ) : _verbose(false), _been_used(false), _min_delta(min_delta), _max_iter(max_iter), _cur_iter(0), _prev_funct_value(0), _libmfr(libmfr)
+    ) : _verbose(false), _been_used(false), _criteria(min_delta, max_iter), _cur_iter(0), _prev_funct_value(0), _libmfr(libmfr)
     {
         DLIB_ASSERT (
             min_delta >= 0 && max_iter > 0,
@@ -195,6 +211,21 @@ public:
             << "\n\t min_delta: " << min_delta
             << "\n\t max_iter:  " << max_iter
         );
+        _timer.start();
+    }
+
+    libmfr_objective_delta_stop_strategy (
+        const TStopCriteria& criteria,
+        libmfr_type *libmfr
+    ) : _verbose(false), _been_used(false), _criteria(criteria), _cur_iter(0), _prev_funct_value(0), _libmfr(libmfr)
+    {
+        DLIB_ASSERT (
+            criteria.minDelta >= 0 && criteria.minRelativeDelta >= 0 &&
+            criteria.minStepNorm >= 0 && criteria.minGradientNorm >= 0 && criteria.maxSeconds >= 0,
+            "\t objective_delta_stop_strategy(criteria)"
+            << "\n\t criteria can't be negative"
+        );
+        _timer.start();
     }
 
     libmfr_objective_delta_stop_strategy<libmfr_type>& be_verbose(
@@ -207,9 +238,9 @@ public:
 
     template <typename T>
     bool should_continue_search (
-        const T& ,
+        const T& x,
         const double funct_value,
-        const T&
+        const T& funct_derivative
     )
     {
 
@@ -233,20 +264,37 @@ public:
         }
 
         ++_cur_iter;
+
+        if (_criteria.maxSeconds > 0 && _timer.elapsed() > 1000 * _criteria.maxSeconds)
+            return false;
+
+        if (_criteria.minGradientNorm > 0 && dlib::length(funct_derivative) < _criteria.minGradientNorm)
+            return false;
+
         if (_been_used)
         {
             // Check if we have hit the max allowable number of iterations.  (but only
-            // check if _max_iter is enabled (i.e. not 0)).
-            if (_max_iter != 0 && _cur_iter > _max_iter)
+            // check if max iterations is enabled (i.e. not 0)).
+            if (_criteria.maxIterations != 0 && _cur_iter > _criteria.maxIterations)
+                return false;
+
+            // find_min_trust_region() asks only after accepted steps,
+            // the changes are therefore those of a single accepted step
+            const double delta = std::abs(funct_value - _prev_funct_value);
+            if (delta < _criteria.minDelta)
+                return false;
+
+            if (_criteria.minRelativeDelta > 0 &&
+                delta < _criteria.minRelativeDelta * std::abs(_prev_funct_value))
                 return false;
 
-            // check if the function change was too small
-            if (std::abs(funct_value - _prev_funct_value) < _min_delta)
+            if (_criteria.minStepNorm > 0 && dlib::length(x - _prev_x) < _criteria.minStepNorm)
                 return false;
         }
 
         _been_used = true;
         _prev_funct_value = funct_value;
+        _prev_x = x;
         return true;
     }
 
@@ -254,10 +302,11 @@ private:
     bool _verbose;
 
     bool _been_used;
-    double _min_delta;
-    unsigned long _max_iter;
+    TStopCriteria _criteria;
     unsigned long _cur_iter;
     double _prev_funct_value;
+    dlib::matrix<double,0,1> _prev_x;
+    QElapsedTimer _timer;
     libmfr_type *_libmfr;
 };
 
@@ -22,6 +22,9 @@
 
 #include <dlib/matrix.h>
 #include "txrayview.h"
+#include "tprojection.h"
+#include "Renderer/tvertexbuffer.h"
+#include "Parallel/tworkerthread.h"
 #include "Observer/tobserver.h"
 
 /**
@@ -31,7 +34,7 @@ template <class MetricType>
 class TBoneFragment
 {    
 public:
-    explicit TBoneFragment(int ViewCount);
+    explicit TBoneFragment(int ViewCount, TRenderer::Backend backend = TRenderer::OpenGLBackend);
     ~TBoneFragment();
 
     void initValuesCount();
@@ -39,6 +42,7 @@ public:
     void setShapeModel(  SSIMRenderer::MatStatisticalDataFile * shapeFile);
     void setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile);
     void setPoseEps(double eps);
+    void enableAsyncMetrics(bool enable);
 
     void setStandardizedShapeParams(  const QVector<float> & shapeParams);
     void setStandardizedDensityParams(const QVector<float> & densityParams);
@@ -63,15 +67,21 @@ public:
     dlib::matrix<float> poseGradient(setPoseType setPose, getPoseType getPose);
     dlib::matrix<float> rotationGradient();
     dlib::matrix<float> translationGradient();    
+    dlib::matrix<float> imagePoseGradient();
+    bool hasPixelValues() const;
+
+    void renderValues(float * values, QVector<QVector<bool> > & masks);
+    void renderValues(float * values);
 
     void updateMasks();
+    void getVerticesMasks(QVector<QVector<bool> > & masks);
 
     inline int getValuesCount() const
     {
         return myValuesCount;
     }
 
-    inline QVector<SSIMRenderer::OffscreenRenderer *> getRenderers()
+    inline QVector<TRenderer *> getRenderers()
     {
         return myRenderers;
     }
@@ -86,6 +96,11 @@ public:
         return myXRayViews;
     }
 
+    inline TVertexBuffer * getVertexBuffer()
+    {
+        return myVertexBuffer;
+    }
+
     void setObserver(TObserver * observer);
     QVector<QVector<QVector3D> > myPlusPoints;
     QVector<QVector<QVector3D> > myMinusPoints;
@@ -96,10 +111,16 @@ signals:
 public slots:
 
 private:
+    void evaluateMetric(int view, const std::function<void(const float *, int)> & consume);
+    void waitForMetric(int view);
+    void waitForMetrics();
+
     QVector<QVector3D> myPoints;
     QVector<TXRayView<MetricType> *> myXRayViews;
-    QVector<SSIMRenderer::OffscreenRenderer *> myRenderers;
+    QVector<TRenderer *> myRenderers;
     QVector<MetricType *> myMetrics;
+    TVertexBuffer * myVertexBuffer;
+    QVector<TWorkerThread *> myMetricWorkers;
     int myValuesCount;
 
     TObserver * myObserver;
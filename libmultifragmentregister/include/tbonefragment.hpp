@@ -18,14 +18,16 @@
  */
 
 #include <assert.h>
+#include <QDebug>
 #include "tbonefragment.h"
 
 /**
  * @brief Constructor of the bone fragment class
  * @param[in] ViewCount Number of radiographs capturing the fragment
+ * @param[in] backend Rendering backend of the radiographs
  */
 template <class MetricType>
-TBoneFragment<MetricType>::TBoneFragment(int ViewCount):
+TBoneFragment<MetricType>::TBoneFragment(int ViewCount, TRenderer::Backend backend):
     myValuesCount(0),
     myObserver(0),
     myPoseEps(1.0)
@@ -34,7 +36,7 @@ TBoneFragment<MetricType>::TBoneFragment(int ViewCount):
     myXRayViews.resize(ViewCount);    
 
     ///qDebug() << "Creating context" << 0;
-    myXRayViews[0] = new TXRayView<MetricType>();    
+    myXRayViews[0] = new TXRayView<MetricType>(NULL, backend);    
     for(int i = 1; i < ViewCount; i++)        
     {
         ///qDebug() << "Creating context" << i;
@@ -49,6 +51,8 @@ TBoneFragment<MetricType>::TBoneFragment(int ViewCount):
         myRenderers[i] = myXRayViews[i]->getRenderer();
         myMetrics[i]   = myXRayViews[i]->getMetric();
     }
+
+    myVertexBuffer = new TVertexBuffer(myRenderers[0]);
 }
 
 /**
@@ -93,11 +97,10 @@ template <class MetricType>
 QVector<float> TBoneFragment<MetricType>::
 getStandardizedShapeParams()
 {
-    SSIMRenderer::StatisticalData * data = myRenderers[0]->getStatisticalData();
-    const int n = data->getNumberOfParameters();
+    const int n = myRenderers[0]->getShapeParamsCount();
     QVector<float> result(n);
     for(int i = 0; i < n; i++)
-        result[i] = data->getPcsMatrix()[i] / data->getStdMatrix()[i];
+        result[i] = myRenderers[0]->getShapeParam(i) / myRenderers[0]->getShapeStd(i);
 
     return result;
 }
@@ -110,11 +113,12 @@ template <class MetricType>
 QVector<float> TBoneFragment<MetricType>::
 getShapeParams()
 {
-    SSIMRenderer::StatisticalData * data = myRenderers[0]->getStatisticalData();
-    const int n = data->getNumberOfParameters();
-    std::vector<float> v;
-    v.assign(data->getPcsMatrix(), data->getPcsMatrix() + n);
-    return QVector<float>::fromStdVector(v);
+    const int n = myRenderers[0]->getShapeParamsCount();
+    QVector<float> result(n);
+    for(int i = 0; i < n; i++)
+        result[i] = myRenderers[0]->getShapeParam(i);
+
+    return result;
 }
 
 template <class MetricType>
@@ -124,11 +128,102 @@ setPoseEps(double eps)
     myPoseEps = eps;
 }
 
+/**
+ * @brief Enables computing the metrics in parallel with rendering of the next radiograph
+ * @param[in] enable Boolean value
+ *
+ * Each radiograph gets its own worker thread computing its metric while
+ * the following radiographs are rendered. The buffer of each renderer is
+ * not rendered again until its metric is finished, all metrics are finished
+ * before the values are returned. The mode requires the software backend,
+ * the OpenGL contexts are bound to the rendering thread.
+ *
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+enableAsyncMetrics(bool enable)
+{
+    if(enable && myRenderers[0]->getBackend() != TRenderer::SoftwareBackend)
+    {
+        qDebug() << "WARNING: Asynchronous metrics require the software backend, disabled";
+        enable = false;
+    }
+
+    if(enable == !myMetricWorkers.isEmpty())
+        return;
+
+    if(enable)
+    {
+        for(int i = 0; i < myMetrics.size(); i++)
+            myMetricWorkers << new TWorkerThread;
+    }
+    else
+    {
+        foreach (TWorkerThread * worker, myMetricWorkers)
+            delete worker;
+        myMetricWorkers.clear();
+    }
+}
+
+/**
+ * @brief Computes the metric of the radiograph from its last rendered image
+ * @param[in] view Index of the radiograph
+ * @param[in] consume Function receiving the metric values and their count
+ *
+ * The metric is computed by the worker thread of the radiograph when the
+ * asynchronous metrics are enabled, immediately otherwise.
+ *
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+evaluateMetric(int view, const std::function<void(const float *, int)> & consume)
+{
+    MetricType * metric = myMetrics[view];
+    if(myMetricWorkers.isEmpty())
+    {
+        consume(metric->getValues(), metric->valuesCount());
+        return;
+    }
+
+    myMetricWorkers[view]->post([metric, consume]() {
+        consume(metric->getValues(), metric->valuesCount());
+    });
+}
+
+/**
+ * @brief Waits until the metric of the radiograph stops reading its rendered image
+ * @param[in] view Index of the radiograph
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+waitForMetric(int view)
+{
+    if(!myMetricWorkers.isEmpty())
+        myMetricWorkers[view]->waitForDone();
+}
+
+/**
+ * @brief Waits until the metrics of all radiographs are computed
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+waitForMetrics()
+{
+    foreach (TWorkerThread * worker, myMetricWorkers)
+        worker->waitForDone();
+}
+
 /**
  * @brief Computes Jacobian matrix of the pose parameters
  * @param[in] setPose Function to adjust the scene using given pose parameters
  * @param[in] getPose Function to obtain current pose parameters from the scene
  * @return Jacobian matrix approximated by central differences method
+ *
+ * All six perturbed poses are rendered by a single batch, see
+ * TRenderer::renderPoses, the metric values are read after each image.
+ * The values of the minus pose are queued after the plus pose of the
+ * same radiograph, the worker threads keep their order.
+ *
  */
 template <class MetricType>
 dlib::matrix<float> TBoneFragment<MetricType>::
@@ -147,15 +242,11 @@ poseGradient(setPoseType setPose,
     for(int i = 0; i < myXRayViews.size(); i++)
         myXRayViews[i]->resizeVertexMasks(ParamCount);
 
-    // Toto alokovat uz v momente, kdy je znama velikost myValuesCount
-    dlib::matrix<float> result(myValuesCount, ParamCount);
-
-    float * vertices = NULL;
-    const int vn = myRenderers.at(0)->getMesh()->getNumberOfVertices();
-
+    // Plus and minus pose of each parameter
+    QVector<QVector3D> rotations;
+    QVector<QVector3D> translations;
     for(int col = 0; col < ParamCount; col++)
     {
-        //qDebug() << "pose param" << col;
         QVector3D  plus(pose);
         QVector3D minus(pose);
 
@@ -163,61 +254,251 @@ poseGradient(setPoseType setPose,
         minus[col] -= eps;
 
         (this->*setPose)(plus);
-        int row = 0;
-        for(int i = 0; i < myRenderers.size(); i++)
-        {
-            if(myObserver != NULL)
-                myObserver->beforeRendering();
+        rotations    << getRotation();
+        translations << getTranslation();
 
-            myRenderers[i]->renderNow();
-            if(vertices == NULL)
-            {
-                myXRayViews[0]->getRenderer()->getRecomputedVertices(vertices);
-            }
+        (this->*setPose)(minus);
+        rotations    << getRotation();
+        translations << getTranslation();
+    }
+    (this->*setPose)(pose);
 
-            if(myObserver != NULL)
-                myObserver->afterRendering();
+    // First row of the values of each radiograph
+    QVector<int> rows(myXRayViews.size());
+    for(int i = 0, row = 0; i < myXRayViews.size(); i++)
+    {
+        rows[i] = row;
+        row += myXRayViews[i]->getMetric()->valuesCount();
+    }
+
+    // Toto alokovat uz v momente, kdy je znama velikost myValuesCount
+    dlib::matrix<float> result(myValuesCount, ParamCount);
 
-            myXRayViews[i]->myPlusMasks[col] = myRenderers[i]->getVerticesMask(vertices, vn, myXRayViews[i]->getOpenGLCrop(), myXRayViews[i]->getAngle());
-            myPlusPoints[col] = getTransformedPoints();
+    int images = rotations.size() * myRenderers.size();
+    QVector<QVector<bool> > masks;
 
-            // toto zkusit predavat jako floatove pole, ne jako vektor
-            float * v = myXRayViews[i]->getMetric()->getValues();
-            for(int j = 0; j < myXRayViews[i]->getMetric()->valuesCount(); j++)
-                result(row++, col) = v[j];
+    if(myObserver != NULL)
+        myObserver->beforeRendering();
+
+    const std::function<void(int, int)> rendering = [&](int, int i)
+    {
+        waitForMetric(i);
+    };
+
+    myRenderers[0]->renderPoses(rotations, translations, myRenderers, [&](int p, int i)
+    {
+        if(myObserver != NULL)
+            myObserver->afterRendering();
+
+        // Masks of all radiographs are computed with the first one
+        const int col = p / 2;
+        if(i == 0)
+            getVerticesMasks(masks);
+        const QVector<bool> & mask = masks.at(i);
+
+        const int row = rows[i];
+        const bool plus = p % 2 == 0;
+        if(plus)
+        {
+            myXRayViews[i]->myPlusMasks[col] = mask;
+            if(i == 0)
+                myPlusPoints[col] = getTransformedPoints();
+        }
+        else
+        {
+            myXRayViews[i]->myMinusMasks[col] = mask;
+            if(i == 0)
+                myMinusPoints[col] = getTransformedPoints();
         }
 
-        (this->*setPose)(minus);
-        row = 0;
-        for(int i = 0; i < myRenderers.size(); i++)
+        // toto zkusit predavat jako floatove pole, ne jako vektor
+        evaluateMetric(i, [&result, row, col, plus, eps](const float * v, int n)
         {
-            if(myObserver != NULL)
-                myObserver->beforeRendering();
+            for(int j = 0; j < n; j++)
+                result(row + j, col) = plus ? v[j] : (result(row + j, col) - v[j]) / (2 * eps);
+        });
 
-            myRenderers[i]->renderNow();            
+        if(--images > 0 && myObserver != NULL)
+            myObserver->beforeRendering();
+    }, rendering);
+    waitForMetrics();
 
-            if(myObserver != NULL)
-                myObserver->afterRendering();
+    return result;
+}
 
-            myXRayViews[i]->myMinusMasks[col] = myRenderers[i]->getVerticesMask(vertices, vn, myXRayViews[i]->getOpenGLCrop(), myXRayViews[i]->getAngle());
-            myMinusPoints[col] = getTransformedPoints();
+/**
+ * @brief Checks whether the metrics of each radiograph are computed per pixel
+ * @return True if the image gradient Jacobian can be used
+ */
+template <class MetricType>
+bool TBoneFragment<MetricType>::
+hasPixelValues() const
+{
+    foreach (MetricType * metric, myMetrics)
+        if(metric->getPixelIndices() == NULL)
+            return false;
+    return true;
+}
 
-            // toto zkusit predavat jako floatove pole, ne jako vektor
-            float * v = myXRayViews[i]->getMetric()->getValues();
-            for(int j = 0; j < myXRayViews[i]->getMetric()->valuesCount(); j++)
+/**
+ * @brief Computes Jacobian matrix of the pose parameters from the rendered image gradients
+ * @return Jacobian matrix, three rotation columns followed by three translation columns
+ *
+ * Each radiograph is rendered only once. The derivative of each pixel value is
+ * the dot product of the spatial gradient of the rendered image and of the
+ * motion of the pixel caused by the pose change, i.e. -grad(I) * d(pixel)/d(pose).
+ * The pixel is lifted to the scene on the plane passing the fragment centroid
+ * and facing the X-ray source. The motion of the lifted point is obtained
+ * from the transformation matrices of slightly changed poses, no rendering is
+ * involved. The metrics have to provide pixel indices of their values.
+ *
+ */
+template <class MetricType>
+dlib::matrix<float> TBoneFragment<MetricType>::
+imagePoseGradient()
+{
+    assert(myValuesCount > 0);
+    const int ParamCount = 6;
+    const float eps = 0.01;
+
+    dlib::matrix<float> result = dlib::zeros_matrix<float>(myValuesCount, ParamCount);
+
+    // Transformations of the slightly rotated and translated fragment
+    const QVector3D rotation    = getRotation();
+    const QVector3D translation = getTranslation();
+    const QMatrix4x4 m = myRenderers[0]->getTransformationMatrix();
+
+    QVector<QMatrix4x4>  plus(ParamCount);
+    QVector<QMatrix4x4> minus(ParamCount);
+    for(int col = 0; col < ParamCount; col++)
+    {
+        QVector3D r(rotation);
+        QVector3D t(translation);
+        QVector3D & pose = (col < 3) ? r : t;
+
+        pose[col % 3] += eps;
+        setRotation(r);
+        setTranslation(t);
+        plus[col] = myRenderers[0]->getTransformationMatrix().inverted();
+
+        pose[col % 3] -= 2 * eps;
+        setRotation(r);
+        setTranslation(t);
+        minus[col] = myRenderers[0]->getTransformationMatrix().inverted();
+    }
+    setRotation(rotation);
+    setTranslation(translation);
+
+    // Centroid of the fragment in the scene coordinates
+    const QVector<float> vertices = myVertexBuffer->getVertices();
+    const int vn = vertices.size() / 3;
+    QVector3D centroid;
+    for(int i = 0; i < vn; i++)
+        centroid += QVector3D(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]);
+    centroid = QVector4D(m.inverted() * QVector4D(centroid / vn, 1)).toVector3DAffine();
+
+    int row = 0;
+    for(int i = 0; i < myRenderers.size(); i++)
+    {
+        if(myObserver != NULL)
+            myObserver->beforeRendering();
+
+        myRenderers[i]->renderNow();
+
+        if(myObserver != NULL)
+            myObserver->afterRendering();
+
+        float * image = NULL;
+        myRenderers[i]->getRenderedRedChannel(image);
+
+        MetricType * metric = myMetrics[i];
+        const int * indices = metric->getPixelIndices();
+        const int n = metric->valuesCount();
+        const int w = metric->getFrameSize().width();
+        const int h = metric->getFrameSize().height();
+
+        const TProjection projection(myXRayViews[i]->getPerspective(), myXRayViews[i]->getSize());
+        const QRect crop = myXRayViews[i]->getCrop();
+
+        for(int j = 0; j < n; j++)
+        {
+            // Rows of the rendered image are stored bottom-up
+            const int x = indices[j] % w;
+            const int y = indices[j] / w;
+
+            const float * p = image + indices[j];
+            const float gx = (x == 0) ? p[1] - p[0] : (x == w - 1) ? p[0] - p[-1] : (p[1] - p[-1]) / 2;
+            const float gy = (y == 0) ? p[w] - p[0] : (y == h - 1) ? p[0] - p[-w] : (p[w] - p[-w]) / 2;
+            if(gx == 0 && gy == 0)
+                continue;
+
+            const QPointF pixel(crop.left() + x + 0.5, crop.top() + h - 1 - y + 0.5);
+            const QVector4D point = m * QVector4D(projection.backProject(pixel, centroid), 1);
+
+            for(int col = 0; col < ParamCount; col++)
             {
-                result(row, col) = (result(row, col) - v[j]) / (2 * eps);
-                row += 1;
+                const QPointF motion = (projection.project(( plus[col] * point).toVector3DAffine()) -
+                                        projection.project((minus[col] * point).toVector3DAffine())) / (2 * eps);
+                result(row + j, col) = -(gx * motion.x() - gy * motion.y());
             }
         }
-    }
 
-    delete vertices;
+        delete[] image;
+        row += n;
+    }
 
-    (this->*setPose)(pose);
     return result;
 }
 
+/**
+ * @brief Renders every radiograph of the fragment in the current pose and shape
+ * @param[out] values Buffer for the image similarity metrics values, at least getValuesCount() long
+ * @param[out] masks Masks of the visible vertices for each radiograph
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+renderValues(float * values, QVector<QVector<bool> > & masks)
+{
+    assert(myValuesCount > 0);
+    getVerticesMasks(masks);
+    renderValues(values);
+}
+
+/**
+ * @brief Renders every radiograph of the fragment in the current pose and shape
+ * @param[out] values Buffer for the image similarity metrics values of all radiographs
+ *
+ * The metric of each radiograph may be computed while the next one is
+ * rendered, see enableAsyncMetrics().
+ *
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+renderValues(float * values)
+{
+    int row = 0;
+    for(int i = 0; i < myRenderers.size(); i++)
+    {
+        waitForMetric(i);
+
+        if(myObserver != NULL)
+            myObserver->beforeRendering();
+
+        myRenderers[i]->renderNow();
+
+        if(myObserver != NULL)
+            myObserver->afterRendering();
+
+        float * data = values + row;
+        evaluateMetric(i, [data](const float * v, int n)
+        {
+            memcpy((void*)data, (const void*)v, n * sizeof(float));
+        });
+        row += myMetrics[i]->valuesCount();
+    }
+    waitForMetrics();
+}
+
 /**
  * @brief Transorms the input point from the original space
  * @return Transformed point
@@ -262,9 +543,17 @@ shapeGradient(unsigned int ParamCount)
     for(int i = 0; i < myXRayViews.size(); i++)
         myXRayViews[i]->resizeVertexMasks(ParamCount);
 
+    // First row of the values of each radiograph
+    QVector<int> rows(myXRayViews.size());
+    for(int i = 0, row = 0; i < myXRayViews.size(); i++)
+    {
+        rows[i] = row;
+        row += myXRayViews[i]->getMetric()->valuesCount();
+    }
+
     // Toto alokovat uz v momente, kdy je znama velikost myValuesCount i ParamCount
     dlib::matrix<float> result(myValuesCount, ParamCount);
-    const int vn = myRenderers.at(0)->getMesh()->getNumberOfVertices();
+    QVector<QVector<bool> > masks;
 
     for(unsigned int col = 0; col < ParamCount; col++)
     {
@@ -277,9 +566,11 @@ shapeGradient(unsigned int ParamCount)
         minus[col] -= eps;
 
         setStandardizedShapeParams(plus);
-        int row = 0;
+        getVerticesMasks(masks);
         for(int i = 0; i < myRenderers.size(); i++)
         {
+            waitForMetric(i);
+
             if(myObserver != NULL)
                 myObserver->beforeRendering();
 
@@ -289,21 +580,22 @@ shapeGradient(unsigned int ParamCount)
                 myObserver->afterRendering();
 
             /*** vertex metrika ***/
-            float * vertices = NULL;
-            myRenderers[0]->getRecomputedVertices(vertices);
-            myXRayViews[i]->myPlusMasks[col] = myRenderers[i]->getVerticesMask(vertices, vn, myXRayViews[i]->getOpenGLCrop(), myXRayViews[i]->getAngle());
-            delete vertices;
-
+            myXRayViews[i]->myPlusMasks[col] = masks.at(i);
 
-            float * v = myXRayViews[i]->getMetric()->getValues();
-            for(int j = 0; j < myXRayViews[i]->getMetric()->valuesCount(); j++)
-                result(row++, col) = v[j];
+            const int row = rows[i];
+            evaluateMetric(i, [&result, row, col](const float * v, int n)
+            {
+                for(int j = 0; j < n; j++)
+                    result(row + j, col) = v[j];
+            });
         }
 
         setStandardizedShapeParams(minus);
-        row = 0;
+        getVerticesMasks(masks);
         for(int i = 0; i < myRenderers.size(); i++)
         {
+            waitForMetric(i);
+
             if(myObserver != NULL)
                 myObserver->beforeRendering();
 
@@ -313,21 +605,18 @@ shapeGradient(unsigned int ParamCount)
                 myObserver->afterRendering();
 
             /*** vertex metrika ***/
-            float * vertices = NULL;
-            myRenderers[0]->getRecomputedVertices(vertices);
-            myXRayViews[i]->myMinusMasks[col] = myRenderers[i]->getVerticesMask(vertices, vn, myXRayViews[i]->getOpenGLCrop(), myXRayViews[i]->getAngle());
-            delete vertices;
-
+            myXRayViews[i]->myMinusMasks[col] = masks.at(i);
 
             // toto zkusit predavat jako floatove pole, ne jako vektor
-            float * v = myXRayViews[i]->getMetric()->getValues();
-            for(int j = 0; j < myXRayViews[i]->getMetric()->valuesCount(); j++)
+            const int row = rows[i];
+            evaluateMetric(i, [&result, row, col, eps](const float * v, int n)
             {
-                result(row, col) = (result(row, col) - v[j]) / (2 * eps);
-                row += 1;
-            }
+                for(int j = 0; j < n; j++)
+                    result(row + j, col) = (result(row + j, col) - v[j]) / (2 * eps);
+            });
         }
     }
+    waitForMetrics();
 
     setStandardizedShapeParams(shape);
     return result;
@@ -364,15 +653,42 @@ template <class MetricType>
 void TBoneFragment<MetricType>::
 updateMasks()
 {
-    long int vn = myRenderers[0]->getMesh()->getNumberOfVertices();
-    float * v = NULL;
-    myRenderers[0]->getRecomputedVertices(v);
-    assert(v != NULL);
+    QVector<QVector<bool> > masks;
+    getVerticesMasks(masks);
+
+    for(int i = 0; i < myXRayViews.size(); i++)
+        myXRayViews[i]->setMask(masks.at(i));
+}
 
+/**
+ * @brief Computes the masks of the vertices visible in each radiograph
+ * @param[out] masks Mask of each radiograph for the current shape and pose
+ *
+ * The masks of all radiographs are computed by a single call of the
+ * renderer, see TRenderer::getVerticesMasks.
+ *
+ */
+template <class MetricType>
+void TBoneFragment<MetricType>::
+getVerticesMasks(QVector<QVector<bool> > & masks)
+{
+    const QVector<float> vertices = myVertexBuffer->getVertices();
+    const int vn = vertices.size() / 3;
+
+    QVector<QRectF> crops;
+    QVector<double> angles;
     foreach (TXRayView<MetricType> * XRayView, myXRayViews)
-        XRayView->updateMask(v, vn);
+    {
+        crops  << XRayView->getOpenGLCrop();
+        angles << XRayView->getAngle();
+    }
 
-    delete v;
+    QVector<QVector<quint64> > bits;
+    myRenderers[0]->getVerticesMasks(vertices.constData(), vn, myRenderers, crops, angles, bits);
+
+    masks.resize(bits.size());
+    for(int i = 0; i < bits.size(); i++)
+        masks[i] = TRenderer::unpackMask(bits.at(i), vn);
 }
 
 /**
@@ -405,7 +721,7 @@ template <class MetricType>
 void TBoneFragment<MetricType>::
 setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile)
 {
-    myRenderers[0]->setVertices(shapeFile);
+    myRenderers[0]->setShapeModel(shapeFile);
 }
 
 /**
@@ -416,7 +732,7 @@ template <class MetricType>
 void TBoneFragment<MetricType>::
 setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile)
 {
-    myRenderers[0]->setCoefficients(densityFile);
+    myRenderers[0]->setDensityModel(densityFile);
 }
 
 /**
@@ -427,11 +743,7 @@ template <class MetricType>
 void TBoneFragment<MetricType>::
 setShapeParams(const QVector<float> & shapeParams)
 {
-    SSIMRenderer::StatisticalData * data = myRenderers[0]->getStatisticalData();
-    for(int i = 0; i < shapeParams.size(); i++)
-        data->updatePcsMatrix(i, shapeParams.at(i));
-
-    myRenderers[0]->updateVertices(data);
+    myRenderers[0]->setShapeParams(shapeParams);
 }
 
 /**
@@ -442,13 +754,11 @@ template <class MetricType>
 void TBoneFragment<MetricType>::
 setStandardizedShapeParams(const QVector<float> & shapeParams)
 {
-    SSIMRenderer::StatisticalData * data = myRenderers[0]->getStatisticalData();
+    QVector<float> scores(shapeParams.size());
     for(int i = 0; i < shapeParams.size(); i++)
-    {
-        const float score = shapeParams.at(i) * data->getStdMatrix()[i];
-        data->updatePcsMatrix(i, score);
-    }
-    myRenderers[0]->updateVertices(data);
+        scores[i] = shapeParams.at(i) * myRenderers[0]->getShapeStd(i);
+
+    myRenderers[0]->setShapeParams(scores);
 }
 
 /**
@@ -496,4 +806,10 @@ setObserver(TObserver * observer)
 template <class MetricType>
 TBoneFragment<MetricType>::~TBoneFragment()
 {
+    enableAsyncMetrics(false);
+    delete myVertexBuffer;
+
+    // Views sharing the context of the first view have to be released first
+    for(int i = myXRayViews.size() - 1; i >= 0; i--)
+        delete myXRayViews[i];
 }
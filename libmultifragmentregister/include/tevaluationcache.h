@@ -0,0 +1,67 @@
+/**
+ * @file        tevaluationcache.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TEvaluationCache class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TEVALUATIONCACHE_H
+#define TEVALUATIONCACHE_H
+
+#include <QVector>
+#include <QLinkedList>
+
+#include <dlib/matrix.h>
+
+/**
+ * @brief Cache of the metrics evaluations for the last few parameter vectors
+ *
+ * Entries are identified by the exact parameter vector and the least
+ * recently used entry is dropped first. As the Jacobian matrix is much
+ * larger than the metric values, it is kept only for the most recently
+ * stored Jacobian.
+ *
+ */
+class TEvaluationCache
+{
+public:
+    /**
+     * @brief Single evaluation of the metrics
+     */
+    struct Entry
+    {
+        dlib::matrix<double, 0, 1> params;
+        QVector<float> values;
+        QVector<QVector<bool> > masks;
+        dlib::matrix<float> jacobian;
+        bool hasValues;
+        bool hasJacobian;
+    };
+
+    explicit TEvaluationCache(int capacity = 4);
+
+    void clear();
+    void setCapacity(int capacity);
+
+    Entry * find(const dlib::matrix<double, 0, 1> & params);
+    Entry * insert(const dlib::matrix<double, 0, 1> & params);
+    void storeJacobian(const dlib::matrix<double, 0, 1> & params, const dlib::matrix<float> & jacobian);
+
+private:
+    QLinkedList<Entry> myEntries;
+    int myCapacity;
+};
+
+#endif // TEVALUATIONCACHE_H
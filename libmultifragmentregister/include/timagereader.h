@@ -0,0 +1,49 @@
+/**
+ * @file        timagereader.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TImageReader class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TIMAGEREADER_H
+#define TIMAGEREADER_H
+
+#include <QImage>
+#include <QRect>
+
+/**
+ * @brief Conversion of the input images to the buffers of the metrics
+ *
+ * The images are converted to 32-bit RGB once and read by whole scan lines,
+ * four pixels at a time by SSE2 when available. The buffers of the metrics
+ * store the rows bottom-up, the same way as the rendered images, so the rows
+ * are mirrored during the conversion.
+ *
+ */
+class TImageReader
+{
+public:
+    static void readRed(const QImage & image, float * data);
+    static void readRedMask(const QImage & image, int threshold, bool * mask);
+    static void readRedBits(const QImage & image, int threshold, bool above, quint64 * bits, int stride);
+
+    static QImage threshold(const QImage & image, int threshold);
+    static QRect bounds(const QImage & image, int threshold);
+
+private:
+    static QImage normalized(const QImage & image);
+};
+
+#endif // TIMAGEREADER_H
@@ -0,0 +1,78 @@
+/**
+ * @file        tprojection.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TProjection class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TPROJECTION_H
+#define TPROJECTION_H
+
+#include <QVector3D>
+#include <QMatrix4x4>
+#include <QPointF>
+#include <QSize>
+
+#include "ssimrenderer.h"
+
+/**
+ * @brief Central projection of the scene onto the radiograph plane
+ *
+ * The projection is given by the perspective pyramid, i.e. by the X-ray
+ * source (eye) and by three corners of the detector. Pixel coordinates
+ * have the origin in the left top corner of the whole radiograph.
+ *
+ */
+class TProjection
+{
+public:
+    TProjection();
+    TProjection(const SSIMRenderer::Pyramid & perspective, const QSize & size);
+
+    QPointF project(const QVector3D & point) const;
+    QVector3D backProject(const QPointF & pixel, const QVector3D & planePoint) const;
+    QMatrix4x4 getMatrix() const;
+
+    inline QVector3D getEye() const
+    {
+        return myEye;
+    }
+
+    inline QVector3D getLeftTop() const
+    {
+        return myLeftTop;
+    }
+
+    inline QVector3D getColumn() const
+    {
+        return myColumn;
+    }
+
+    inline QVector3D getRow() const
+    {
+        return myRow;
+    }
+
+private:
+    QVector3D myEye;
+    QVector3D myLeftTop;
+    QVector3D myColumn;
+    QVector3D myRow;
+    QVector3D myU;
+    QVector3D myV;
+    QVector3D myW;
+};
+
+#endif // TPROJECTION_H
@@ -0,0 +1,60 @@
+/**
+ * @file        tscenesnapshot.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TSceneSnapshot class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TSCENESNAPSHOT_H
+#define TSCENESNAPSHOT_H
+
+#include <QVector>
+#include <QVector3D>
+
+#include <dlib/matrix.h>
+
+/**
+ * @brief Immutable copy of the registration parameters
+ *
+ * The snapshot stores the pose of each fragment, the standardized shape
+ * parameters and the iteration of the pixel subset. Together with the
+ * settings of the registration, i.e. the models, images, masks and the
+ * target values, it fully determines the metrics values. The containers
+ * are implicitly shared, the snapshot is cheap to copy between threads.
+ *
+ */
+class TSceneSnapshot
+{
+public:
+    TSceneSnapshot();
+    TSceneSnapshot(const QVector<QVector3D> & rotations,
+                   const QVector<QVector3D> & translations,
+                   const QVector<float> & shape,
+                   unsigned int sampleIteration);
+
+    TSceneSnapshot withParams(const dlib::matrix<double, 0, 1> & params) const;
+    dlib::matrix<double, 0, 1> toParams(unsigned int shapeCount) const;
+
+    /// Rotation of each fragment
+    QVector<QVector3D> rotations;
+    /// Translation of each fragment
+    QVector<QVector3D> translations;
+    /// Standardized shape parameters
+    QVector<float> shape;
+    /// Iteration of the random or stratified pixel subset
+    unsigned int sampleIteration;
+};
+
+#endif // TSCENESNAPSHOT_H
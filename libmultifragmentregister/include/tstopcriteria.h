@@ -0,0 +1,52 @@
+/**
+ * @file        tstopcriteria.h
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The header file containing the TStopCriteria class declaration.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef TSTOPCRITERIA_H
+#define TSTOPCRITERIA_H
+
+/**
+ * @brief Convergence criteria of the registration
+ *
+ * The optimization stops as soon as any of the enabled criteria is met.
+ * Criteria set to zero are disabled. The criteria are evaluated after
+ * accepted steps only, the changes of the objective and the step norm
+ * are those of the last accepted step.
+ *
+ */
+class TStopCriteria
+{
+public:
+    TStopCriteria();
+    TStopCriteria(double minDelta, unsigned long maxIterations);
+
+    /// Minimal absolute change of the objective
+    double minDelta;
+    /// Minimal change of the objective relative to its previous value
+    double minRelativeDelta;
+    /// Minimal Euclidean norm of the parameters step
+    double minStepNorm;
+    /// Minimal Euclidean norm of the objective gradient
+    double minGradientNorm;
+    /// Maximal number of iterations
+    unsigned long maxIterations;
+    /// Maximal duration of the optimization in seconds
+    double maxSeconds;
+};
+
+#endif // TSTOPCRITERIA_H
@@ -24,6 +24,7 @@
 #include <QVector>
 #include <QRectF>
 #include "ssimrenderer.h"
+#include "Renderer/trenderer.h"
 #include "ImageMetric/timagemetric.h"
 #include "Observer/tobserver.h"
 
@@ -34,17 +35,18 @@ template <class MetricType>
 class TXRayView
 {
 public:
-    TXRayView(SSIMRenderer::OffscreenRenderer * renderer = NULL);
+    TXRayView(TRenderer * renderer = NULL, TRenderer::Backend backend = TRenderer::OpenGLBackend);
     ~TXRayView();
 
-    SSIMRenderer::OffscreenRenderer * getRenderer();
+    TRenderer * getRenderer();
     MetricType * getMetric();
 
     void setObserver(TObserver * observer);
     void resizeVertexMasks(int n);
 
-    void updateMask(float * v, int vn);
+    void updateMask(const float * v, int vn);
     inline QVector<bool> getMask();
+    void setMask(const QVector<bool> & mask);
 
     QVector<QVector<bool> > myPlusMasks;
     QVector<QVector<bool> > myMinusMasks;
@@ -54,14 +56,25 @@ public:
     void setAngle(double angle);
     double getAngle() const;
 
+    void setPerspective(const SSIMRenderer::Pyramid & perspective);
+    SSIMRenderer::Pyramid getPerspective() const;
+    void setSize(const QSize & size);
+    QSize getSize() const;
+    void setCrop(const QRect & crop);
+    QRect getCrop() const;
+
 private:
     QVector<bool> myMask;
 
-    SSIMRenderer::OffscreenRenderer * myRenderer;
+    TRenderer * myRenderer;
     MetricType * myImageMetric;
     TObserver  * myObserver;
     QRectF myOpenGLCrop;
     double myAngle;
+
+    SSIMRenderer::Pyramid myPerspective;
+    QSize mySize;
+    QRect myCrop;
 };
 
 #include "txrayview.hpp"
@@ -18,15 +18,17 @@
  */
 
 #include "txrayview.h"
+#include "Renderer/trendererpool.h"
 #include <assert.h>
 
 /**
  * @brief Constructor of the radiograph class
  * @param[in] renderer Pointer to the parent shared renderer
+ * @param[in] backend Rendering backend, the backend of the parent renderer is used if given
  */
 template <class MetricType>
-TXRayView<MetricType>::TXRayView(SSIMRenderer::OffscreenRenderer *renderer):
-    myRenderer(new SSIMRenderer::OffscreenRenderer(512, 512, renderer)),
+TXRayView<MetricType>::TXRayView(TRenderer * renderer, TRenderer::Backend backend):
+    myRenderer(TRendererPool::acquire(renderer != NULL ? renderer->getBackend() : backend, renderer)),
     myImageMetric(new MetricType(myRenderer)),
     myObserver(0)
 {
@@ -37,7 +39,7 @@ TXRayView<MetricType>::TXRayView(SSIMRenderer::OffscreenRenderer *renderer):
  * @return Pointer to the renderer
  */
 template <class MetricType>
-SSIMRenderer::OffscreenRenderer * TXRayView<MetricType>::getRenderer()
+TRenderer * TXRayView<MetricType>::getRenderer()
 {
     return myRenderer;
 }
@@ -93,7 +95,7 @@ getAngle() const
  */
 template <class MetricType>
 void TXRayView<MetricType>::
-updateMask(float * v, int vn)
+updateMask(const float * v, int vn)
 {
     myMask = myRenderer->getVerticesMask(v, vn, myOpenGLCrop, myAngle);
 }
@@ -109,12 +111,25 @@ getMask()
     return myMask;
 }
 
+/**
+ * @brief Sets the mask of the visible vertices, e.g. a previously stored one
+ * @param[in] mask Vertices mask
+ */
+template <class MetricType>
+void TXRayView<MetricType>::
+setMask(const QVector<bool> & mask)
+{
+    myMask = mask;
+}
+
 /**
  * @brief Radiograph class destructor
  */
 template <class MetricType>
 TXRayView<MetricType>::~TXRayView()
 {
+    delete myImageMetric;
+    TRendererPool::release(myRenderer);
 }
 
 /**
@@ -150,3 +165,72 @@ getOpenGLCrop() const
 {
     return myOpenGLCrop;
 }
+
+/**
+ * @brief Sets the perspective pyramid of the radiograph
+ * @param[in] perspective Perspective pyramid
+ */
+template <class MetricType>
+void TXRayView<MetricType>::
+setPerspective(const SSIMRenderer::Pyramid & perspective)
+{
+    myPerspective = perspective;
+    myRenderer->setPerspective(perspective);
+}
+
+/**
+ * @brief Gets the perspective pyramid of the radiograph
+ * @return Perspective pyramid
+ */
+template <class MetricType>
+SSIMRenderer::Pyramid TXRayView<MetricType>::
+getPerspective() const
+{
+    return myPerspective;
+}
+
+/**
+ * @brief Sets the size of the whole radiograph
+ * @param[in] size Size in pixels
+ */
+template <class MetricType>
+void TXRayView<MetricType>::
+setSize(const QSize & size)
+{
+    mySize = size;
+    myRenderer->setRenderSize(size.width(), size.height());
+}
+
+/**
+ * @brief Gets the size of the whole radiograph
+ * @return Size in pixels
+ */
+template <class MetricType>
+QSize TXRayView<MetricType>::
+getSize() const
+{
+    return mySize;
+}
+
+/**
+ * @brief Sets the crop of the rendered part of the radiograph
+ * @param[in] crop Rectangle crop in pixels
+ */
+template <class MetricType>
+void TXRayView<MetricType>::
+setCrop(const QRect & crop)
+{
+    myCrop = crop;
+    myRenderer->setCropWindow(crop);
+}
+
+/**
+ * @brief Gets the crop of the rendered part of the radiograph
+ * @return Rectangle crop in pixels
+ */
+template <class MetricType>
+QRect TXRayView<MetricType>::
+getCrop() const
+{
+    return myCrop;
+}
@@ -49,7 +49,22 @@ SOURCES += \
     src/VertexMetric/tsquareddifferencesvertexmetric.cpp \
     src/libmultifragmentregisterabstract.cpp \
     src/VertexMetric/tpoint2pointvertexmetric.cpp \
-    src/ImageMetric/tsimplemetricmask.cpp
+    src/ImageMetric/tsimplemetricmask.cpp \
+    src/Parallel/tworkerthread.cpp \
+    src/Parallel/tworkerpool.cpp \
+    src/tprojection.cpp \
+    src/tevaluationcache.cpp \
+    src/tstopcriteria.cpp \
+    src/tscenesnapshot.cpp \
+    src/timagereader.cpp \
+    src/Renderer/trenderer.cpp \
+    src/Renderer/topenglrenderer.cpp \
+    src/Renderer/tsoftwarerenderer.cpp \
+    src/Renderer/tmodeldata.cpp \
+    src/Renderer/tvertexbuffer.cpp \
+    src/Renderer/trendererpool.cpp \
+    src/ImageMetric/tsimplenormalizedmutualinformationmetric.cpp \
+    src/ImageMetric/tbinarymetric.cpp
 
 
 HEADERS += \
@@ -76,7 +91,22 @@ HEADERS += \
     include/libmultifragmentregisterabstract.h \
     include/VertexMetric/tsquareddifferencesvertexmetric.h \
     include/VertexMetric/tpoint2pointvertexmetric.h \
-    include/ImageMetric/tsimplemetricmask.h
+    include/ImageMetric/tsimplemetricmask.h \
+    include/Parallel/tworkerthread.h \
+    include/Parallel/tworkerpool.h \
+    include/tprojection.h \
+    include/tevaluationcache.h \
+    include/tstopcriteria.h \
+    include/tscenesnapshot.h \
+    include/timagereader.h \
+    include/Renderer/trenderer.h \
+    include/Renderer/topenglrenderer.h \
+    include/Renderer/tsoftwarerenderer.h \
+    include/Renderer/tmodeldata.h \
+    include/Renderer/tvertexbuffer.h \
+    include/Renderer/trendererpool.h \
+    include/ImageMetric/tsimplenormalizedmutualinformationmetric.h \
+    include/ImageMetric/tbinarymetric.h
 
 # Dependents
 include(libmultifragmentregister_dependents.pri)
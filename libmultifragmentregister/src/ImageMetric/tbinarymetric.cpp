@@ -0,0 +1,182 @@
+/**
+ * @file        tbinarymetric.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TBinaryMetric class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "ImageMetric/tbinarymetric.h"
+#include "timagereader.h"
+
+#include <math.h>
+#include <assert.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Counts the set bits of a word
+ * @param x Word
+ * @return Number of set bits
+ */
+static inline int popcount(quint64 x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return int(__popcnt64(x));
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return int((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * @brief Constructor of TBinaryMetric class
+ * @param renderer Pointer to the shared parent renderer
+ */
+TBinaryMetric::
+TBinaryMetric(TRenderer * renderer):
+    TImageMetric(renderer)
+{
+    myRenderer->enableBitMask(true);
+}
+
+/**
+ * @brief Packs the pixels of an image
+ * @param image Image
+ * @param covered Packs the pixels with the red channel above 127 if set, the zero pixels otherwise
+ * @return Packed mask, rows are stored bottom-up
+ */
+QVector<quint64> TBinaryMetric::packImage(const QImage & image, bool covered)
+{
+    const int stride = TRenderer::getBitsStride(image.width());
+
+    QVector<quint64> bits(stride * image.height(), 0);
+    if(covered)
+        TImageReader::readRedBits(image, 127, true, bits.data(), stride);
+    else
+        TImageReader::readRedBits(image, 0, false, bits.data(), stride);
+
+    return bits;
+}
+
+/**
+ * @brief Sets the original binary radiograph image
+ * @param image Radiograph image
+ */
+void TBinaryMetric::setImage(const QImage & image)
+{
+    myOriginalSize = image.size();
+    myRefBits = packImage(image, true);
+
+    if(myMaskBits.size() != myRefBits.size())
+    {
+        QImage mask(image.size(), QImage::Format_RGB32);
+        mask.fill(Qt::black);
+        myMaskBits = packImage(mask, false);
+    }
+
+    updateWords();
+}
+
+/**
+ * @brief Sets the mask
+ * @param mask Mask image, the pixels with a non-zero red channel are excluded
+ */
+void TBinaryMetric::setMask(const QImage & mask)
+{
+    myMaskBits = packImage(mask, false);
+    if(myMaskBits.size() == myRefBits.size())
+        updateWords();
+}
+
+/**
+ * @brief Selects the words containing compared pixels
+ */
+void TBinaryMetric::updateWords()
+{
+    myWords.clear();
+    for(int i = 0; i < myMaskBits.size(); i++)
+        if(myMaskBits.at(i) != 0)
+            myWords.append(i);
+
+    myData.fill(0.0f, myWords.size());
+    myRefData.fill(0.0f, myWords.size());
+}
+
+/**
+ * @brief Get current values of the binary metric
+ * @return Square roots of the mismatch counts of the compared words
+ */
+float * TBinaryMetric::getValues()
+{
+    if(myObserver != NULL)
+        myObserver->beforeMetric();
+
+    myRenderer->getRenderedBits(myBits);
+    assert(myBits.size() == myRefBits.size());
+
+    const quint64 * bits = myBits.constData();
+    const quint64 * ref  = myRefBits.constData();
+    const quint64 * mask = myMaskBits.constData();
+    for(int k = 0; k < myWords.size(); k++)
+    {
+        const int i = myWords.at(k);
+        myData[k] = sqrt(float(popcount((bits[i] ^ ref[i]) & mask[i])));
+    }
+
+    if(myObserver != NULL)
+        myObserver->afterMetric();
+
+    return myData.data();
+}
+
+/**
+ * @brief Gets target values for the binary metric
+ * @return Zero mismatch counts
+ */
+float * TBinaryMetric::getTargetValues()
+{
+    return myRefData.data();
+}
+
+/**
+ * @brief Gets size of the rendered image
+ * @return Size of the rendered image
+ */
+QSize TBinaryMetric::getFrameSize() const
+{
+    return myOriginalSize;
+}
+
+/**
+ * @brief Gets the value count for the binary metric
+ * @return Number of the compared words
+ */
+int TBinaryMetric::valuesCount() const
+{
+    return myWords.size();
+}
+
+/**
+ * @brief Destructor of TBinaryMetric class
+ */
+TBinaryMetric::~TBinaryMetric()
+{
+}
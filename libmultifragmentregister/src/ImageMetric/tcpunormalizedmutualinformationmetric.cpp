@@ -18,17 +18,28 @@
  */
 
 #include "ImageMetric/tcpunormalizedmutualinformationmetric.h"
+#include "Parallel/tworkerpool.h"
+#include "timagereader.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TCPUNORMALIZEDMUTUALINFORMATIONMETRIC_SSE2
+#endif
 
 /**
  * @brief Constructor of TCPUNormalizedMutualInformationMetric class
  * @param renderer Pointer to the shared parent renderer
  */
 TCPUNormalizedMutualInformationMetric::
-TCPUNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TCPUNormalizedMutualInformationMetric(TRenderer * renderer):
     TImageMetric(renderer),
-    nmiComputing(new SSIMRenderer::NMIComputingCPU(64, renderer))
+    myBinsCount(64),
+    myPartialVolume(false),
+    myData(0),
+    myRefData(2)
 {
-    myRefData = 2;
 }
 
 /**
@@ -37,7 +48,21 @@ TCPUNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer
  */
 void TCPUNormalizedMutualInformationMetric::setHistogramBinsCount(int count)
 {
-    nmiComputing->setHistogramBinsCount(count);
+    myBinsCount = count;
+    updateBins();
+}
+
+/**
+ * @brief Enables the partial volume interpolation of the rendered values
+ * @param enable Boolean value
+ *
+ * Each rendered value contributes to the two nearest bins in proportion
+ * to its distance from their centres, which makes the metric smoother.
+ *
+ */
+void TCPUNormalizedMutualInformationMetric::setPartialVolume(bool enable)
+{
+    myPartialVolume = enable;
 }
 
 /**
@@ -46,19 +71,140 @@ void TCPUNormalizedMutualInformationMetric::setHistogramBinsCount(int count)
  */
 void TCPUNormalizedMutualInformationMetric::setImage(const QImage & image)
 {
-    nmiComputing->setInputImage(image);
+    myImage.resize(image.width() * image.height());
+    TImageReader::readRed(image, myImage.data());
+
+    updateBins();
+}
+
+/**
+ * @brief Quantizes the original radiograph into the rows of the joint histogram
+ */
+void TCPUNormalizedMutualInformationMetric::updateBins()
+{
+    myImageBins.resize(myImage.size());
+    for(int i = 0; i < myImage.size(); i++)
+        myImageBins[i] = qBound(0, int(myImage.at(i) * myBinsCount), myBinsCount - 1) * myBinsCount;
+}
+
+/**
+ * @brief Fills the joint histogram of a range of pixels
+ * @param[in] data Rendered red channel
+ * @param[in] begin Index of the first pixel
+ * @param[in] end Index after the last pixel
+ * @param[out] histogram Joint histogram of myBinsCount * myBinsCount bins, cleared by the function
+ */
+void TCPUNormalizedMutualInformationMetric::
+fillHistogram(const float * data, int begin, int end, float * histogram) const
+{
+    const int bins = myBinsCount;
+    const int * rows = myImageBins.constData();
+    std::fill(histogram, histogram + bins * bins, 0.0f);
+
+    int i = begin;
+    if(myPartialVolume)
+    {
+        // Position relative to the bin centres, the weight is split between lo and lo + 1
+#ifdef TCPUNORMALIZEDMUTUALINFORMATIONMETRIC_SSE2
+        const __m128 scale = _mm_set1_ps(bins);
+        const __m128 half  = _mm_set1_ps(0.5f);
+        const __m128 zero  = _mm_setzero_ps();
+        const __m128 last  = _mm_set1_ps(bins - 1);
+        for(; i + 4 <= end; i += 4)
+        {
+            const __m128 t = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(data + i), scale), half), zero), last);
+            const __m128i lo = _mm_cvttps_epi32(t);
+            const __m128 frac = _mm_sub_ps(t, _mm_cvtepi32_ps(lo));
+
+            int lanes[4];
+            float weights[4];
+            _mm_storeu_si128((__m128i *)lanes, _mm_add_epi32(lo, _mm_loadu_si128((const __m128i *)(rows + i))));
+            _mm_storeu_ps(weights, frac);
+            for(int k = 0; k < 4; k++)
+            {
+                histogram[lanes[k]] += 1.0f - weights[k];
+                if(weights[k] > 0.0f)
+                    histogram[lanes[k] + 1] += weights[k];
+            }
+        }
+#endif
+        for(; i < end; i++)
+        {
+            const float t = qBound(0.0f, data[i] * bins - 0.5f, float(bins - 1));
+            const int lo = int(t);
+            const float frac = t - lo;
+            histogram[rows[i] + lo] += 1.0f - frac;
+            if(frac > 0.0f)
+                histogram[rows[i] + lo + 1] += frac;
+        }
+        return;
+    }
+
+#ifdef TCPUNORMALIZEDMUTUALINFORMATIONMETRIC_SSE2
+    const __m128 scale = _mm_set1_ps(bins);
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 last  = _mm_set1_ps(bins - 1);
+    for(; i + 4 <= end; i += 4)
+    {
+        const __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(data + i), scale), zero), last);
+        const __m128i bin = _mm_add_epi32(_mm_cvttps_epi32(v), _mm_loadu_si128((const __m128i *)(rows + i)));
+
+        int lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, bin);
+        histogram[lanes[0]]++;
+        histogram[lanes[1]]++;
+        histogram[lanes[2]]++;
+        histogram[lanes[3]]++;
+    }
+#endif
+    for(; i < end; i++)
+        histogram[rows[i] + qBound(0, int(data[i] * bins), bins - 1)]++;
 }
 
 /**
  * @brief Get current value of NMI metric
  * @return NMI metric value
+ *
+ * NMI = (H(A) + H(B)) / H(A, B), the entropies are given by the joint
+ * histogram of the original and the rendered radiograph.
+ *
  */
 float * TCPUNormalizedMutualInformationMetric::getValues()
 {
     if(myObserver != NULL)
         myObserver->beforeMetric();
 
-    myData = nmiComputing->compute();
+    float * data = NULL;
+    myRenderer->getRenderedRedChannel(data);
+
+    // Each thread of the shared pool fills its own histogram of a range of pixels
+    const int n = myImageBins.size();
+    const int bins = myBinsCount;
+    const int threads = qBound(1, n / MinPixelsPerThread, myWorkerPool != NULL ? myWorkerPool->size() : 1);
+
+    myHistograms.resize(threads);
+    for(int t = 0; t < threads; t++)
+        myHistograms[t].resize(bins * bins);
+
+    if(threads > 1)
+    {
+        myWorkerPool->run(threads, [this, data, n, threads](int t) {
+            fillHistogram(data, qint64(n) * t / threads, qint64(n) * (t + 1) / threads, myHistograms[t].data());
+        });
+    }
+    else
+        fillHistogram(data, 0, n, myHistograms[0].data());
+    delete[] data;
+
+    float * histogram = myHistograms[0].data();
+    for(int t = 1; t < threads; t++)
+    {
+        const float * other = myHistograms.at(t).constData();
+        for(int i = 0; i < bins * bins; i++)
+            histogram[i] += other[i];
+    }
+
+    myData = normalizedMutualInformation(histogram, bins, n);
 
     if(myObserver != NULL)
         myObserver->afterMetric();
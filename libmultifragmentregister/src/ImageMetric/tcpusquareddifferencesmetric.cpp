@@ -18,17 +18,115 @@
  */
 
 #include "ImageMetric/tcpusquareddifferencesmetric.h"
+#include "timagereader.h"
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TCPUSQUAREDDIFFERENCESMETRIC_SSE2
+#endif
+
+namespace {
+
+/**
+ * @brief Gets four bits of a packed mask row
+ * @param[in] mask Packed mask row padded by one word
+ * @param[in] x Index of the first bit
+ * @return Bits x to x + 3 in the lowest bits
+ */
+inline unsigned int maskNibble(const quint64 * mask, int x)
+{
+    const int word  = x / 64;
+    const int shift = x % 64;
+    quint64 bits = mask[word] >> shift;
+    if(shift > 60)
+        bits |= mask[word + 1] << (64 - shift);
+    return bits & 0xF;
+}
+
+/**
+ * @brief Sums the squared differences and the squared targets of a row segment
+ * @param[in] rendered Rendered values of the segment
+ * @param[in] target Target values of the segment
+ * @param[in] mask Packed mask row of the used pixels, null pointer if all pixels are used
+ * @param[in] x Column of the first pixel of the segment
+ * @param[in] n Number of pixels
+ * @param[out] d2 Sum of the squared differences
+ * @param[out] t2 Sum of the squared target values
+ */
+void squaredDifferences(const float * rendered, const float * target, const quint64 * mask,
+                        int x, int n, double & d2, double & t2)
+{
+    int i = 0;
+    float sd = 0;
+    float st = 0;
+
+#ifdef TCPUSQUAREDDIFFERENCESMETRIC_SSE2
+    // Lanes of the used pixels for each combination of four mask bits
+    static const quint32 lanes[16][4] = {
+        {0, 0, 0, 0}, {~0u, 0, 0, 0}, {0, ~0u, 0, 0}, {~0u, ~0u, 0, 0},
+        {0, 0, ~0u, 0}, {~0u, 0, ~0u, 0}, {0, ~0u, ~0u, 0}, {~0u, ~0u, ~0u, 0},
+        {0, 0, 0, ~0u}, {~0u, 0, 0, ~0u}, {0, ~0u, 0, ~0u}, {~0u, ~0u, 0, ~0u},
+        {0, 0, ~0u, ~0u}, {~0u, 0, ~0u, ~0u}, {0, ~0u, ~0u, ~0u}, {~0u, ~0u, ~0u, ~0u}
+    };
+
+    __m128 sumd = _mm_setzero_ps();
+    __m128 sumt = _mm_setzero_ps();
+    for(; i + 4 <= n; i += 4)
+    {
+        const __m128 r = _mm_loadu_ps(rendered + i);
+        const __m128 t = _mm_loadu_ps(target + i);
+        const __m128 d = _mm_sub_ps(r, t);
+        __m128 dd = _mm_mul_ps(d, d);
+        __m128 tt = _mm_mul_ps(t, t);
+        if(mask != NULL)
+        {
+            const __m128 m = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)lanes[maskNibble(mask, x + i)]));
+            dd = _mm_and_ps(dd, m);
+            tt = _mm_and_ps(tt, m);
+        }
+        sumd = _mm_add_ps(sumd, dd);
+        sumt = _mm_add_ps(sumt, tt);
+    }
+
+    float lane[4];
+    _mm_storeu_ps(lane, sumd);
+    sd = lane[0] + lane[1] + lane[2] + lane[3];
+    _mm_storeu_ps(lane, sumt);
+    st = lane[0] + lane[1] + lane[2] + lane[3];
+#endif
+
+    for(; i < n; i++)
+    {
+        if(mask != NULL && !((mask[(x + i) / 64] >> ((x + i) % 64)) & 1))
+            continue;
+        const float d = rendered[i] - target[i];
+        sd += d * d;
+        st += target[i] * target[i];
+    }
+
+    d2 = sd;
+    t2 = st;
+}
+
+}
 
 /**
  * @brief Constructor of TCPUSquaredDifferencesMetric class
  * @param renderer Pointer to the shared parent renderer
  */
 TCPUSquaredDifferencesMetric::
-TCPUSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TCPUSquaredDifferencesMetric(TRenderer * renderer):
     TImageMetric(renderer),
-    mySSDComputing(new SSIMRenderer::SSDComputingCPU(renderer))
+    myRefData(0),
+    myMaskStride(0),
+    myTileSize(0),
+    myData(0),
+    myTargetData(0),
+    myN(0)
 {
-    myRefData = 0;
 }
 
 /**
@@ -37,48 +135,227 @@ TCPUSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer):
  */
 void TCPUSquaredDifferencesMetric::setImage(const QImage & image)
 {
-    mySSDComputing->setInputImage(image);
+    myOriginalSize = image.size();
+
+    delete[] myRefData;
+    myRefData = new float[image.width() * image.height()];
+
+    TImageReader::readRed(image, myRefData);
+
+    myEnergyRegion = QRect();
+    resizeData();
+}
+
+/**
+ * @brief Sets the mask of ignored pixels
+ * @param mask Mask image, the pixels with non-zero red channel are ignored
+ */
+void TCPUSquaredDifferencesMetric::setMask(const QImage & mask)
+{
+    myMaskBits.clear();
+    myMaskStride = 0;
+    myEnergyRegion = QRect();
+    if(mask.isNull())
+        return;
+
+    // One word of padding allows to read four bits at any position
+    myMaskStride = TRenderer::getBitsStride(mask.width()) + 1;
+    myMaskBits.fill(0, myMaskStride * mask.height());
+    TImageReader::readRedBits(mask, 0, false, myMaskBits.data(), myMaskStride);
+}
+
+/**
+ * @brief Sets the size of the tiles summed separately
+ * @param size Size of the square tile in pixels, a single value is computed for 0
+ *
+ * Each tile of the crop rectangle provides the square root of its partial
+ * SSD, the sum of the squared values is equal to the SSD of the whole crop.
+ *
+ */
+void TCPUSquaredDifferencesMetric::setTileSize(int size)
+{
+    assert(size >= 0);
+    myTileSize = size;
+    myEnergyRegion = QRect();
+    resizeData();
+}
+
+/**
+ * @brief Gets the rectangle of the evaluated pixels
+ * @return Crop rectangle in the rendered image coordinates, rows are counted bottom-up
+ *
+ * The crop is given in the radiograph coordinates, while the rendered image
+ * and the radiograph of the metric cover the crop window of the renderer.
+ *
+ */
+QRect TCPUSquaredDifferencesMetric::getRegion() const
+{
+    const QRect frame(QPoint(0, 0), myOriginalSize);
+    if(myCrop.isNull())
+        return frame;
+
+    const QRect crop = myCrop.translated(-myRenderer->getCropWindow().topLeft());
+    return QRect(crop.left(), myOriginalSize.height() - 1 - crop.bottom(), crop.width(), crop.height()) & frame;
+}
+
+/**
+ * @brief Gets the number of tiles in each direction
+ * @return Number of tile columns and rows
+ */
+QSize TCPUSquaredDifferencesMetric::getTilesCount() const
+{
+    if(myTileSize == 0)
+        return QSize(1, 1);
+
+    const QRect region = getRegion();
+    return QSize((region.width()  + myTileSize - 1) / myTileSize,
+                 (region.height() + myTileSize - 1) / myTileSize);
+}
+
+/**
+ * @brief Allocates the values for the current tiles
+ */
+void TCPUSquaredDifferencesMetric::resizeData()
+{
+    const int n = valuesCount();
+    if(n == myN)
+        return;
+
+    delete[] myData;
+    delete[] myTargetData;
+
+    myN = n;
+    myData = new float[myN];
+    myTargetData = new float[myN];
+    std::fill(myTargetData, myTargetData + myN, 0.0f);
+}
+
+/**
+ * @brief Precomputes the squared target values of each tile
+ *
+ * The energies are the values of the metric for an empty rendered image.
+ *
+ */
+void TCPUSquaredDifferencesMetric::updateEnergies()
+{
+    const QRect region = getRegion();
+    if(region == myEnergyRegion)
+        return;
+
+    const QSize tiles = getTilesCount();
+    const int tile = myTileSize == 0 ? qMax(region.width(), region.height()) : myTileSize;
+    const int w = myOriginalSize.width();
+    assert(myMaskBits.isEmpty() || myMaskBits.size() >= myMaskStride * myOriginalSize.height());
+    assert(myMaskBits.isEmpty() || myMaskStride > TRenderer::getBitsStride(w));
+
+    myEnergies.fill(0, tiles.width() * tiles.height());
+    for(int y = region.top(); y <= region.bottom(); y++)
+    {
+        const quint64 * mask = myMaskBits.isEmpty() ? NULL : myMaskBits.constData() + y * myMaskStride;
+        const float * target = myRefData + y * w;
+        for(int x = region.left(); x <= region.right(); x++)
+        {
+            if(mask != NULL && !((mask[x / 64] >> (x % 64)) & 1))
+                continue;
+
+            const int i = ((y - region.top()) / tile) * tiles.width() + (x - region.left()) / tile;
+            myEnergies[i] += target[x] * target[x];
+        }
+    }
+
+    myEnergyRegion = region;
 }
 
 /**
  * @brief Get current value of SSD metric
- * @return SSD metric value
+ * @return Square root of the SSD of the crop or of each tile
  */
 float * TCPUSquaredDifferencesMetric::getValues()
 {
     if(myObserver != NULL)
         myObserver->beforeMetric();
 
-    myData = mySSDComputing->compute();
+    resizeData();
+    updateEnergies();
+
+    const QRect region = getRegion();
+    const QSize tiles = getTilesCount();
+    const int tile = myTileSize == 0 ? qMax(region.width(), region.height()) : myTileSize;
+    const int w = myOriginalSize.width();
+
+    // Pixels outside the bounds are not rendered, their differences are the precomputed energies
+    QVector<double> sums = myEnergies;
+    const QRect rendered = myRenderer->getRenderedBounds();
+    const QRect bounds = rendered & region;
+    if(!bounds.isEmpty())
+    {
+        // The buffer of the renderer is read in place
+        int stride = 0;
+        const float * image = myRenderer->getRenderedRedChannelBuffer(stride);
+
+        for(int y = bounds.top(); y <= bounds.bottom(); y++)
+        {
+            const quint64 * mask = myMaskBits.isEmpty() ? NULL : myMaskBits.constData() + y * myMaskStride;
+            const float * values = image + y * stride;
+            const float * target = myRefData + y * w;
+            const int row = ((y - region.top()) / tile) * tiles.width();
+
+            for(int x = bounds.left(); x <= bounds.right(); )
+            {
+                const int col = (x - region.left()) / tile;
+                const int end = qMin(bounds.right() + 1, region.left() + (col + 1) * tile);
+
+                double d2, t2;
+                squaredDifferences(values + x, target + x, mask, x, end - x, d2, t2);
+                sums[row + col] += d2 - t2;
+                x = end;
+            }
+        }
+    }
+
+    // Residuals of the partial sums, rounding may make the sums slightly negative
+    for(int i = 0; i < myN; i++)
+        myData[i] = sqrt(qMax(0.0, sums.at(i)));
 
     if(myObserver != NULL)
         myObserver->afterMetric();
 
-    return &myData;
+    return myData;
 }
 
 /**
  * @brief Gets target values for the SSD metric
- * @return SSD target value
+ * @return SSD target values
  *
- * In case of SSD metric the target value is equal to 0
+ * In case of SSD metric the target values are equal to 0
  *
  */
 float * TCPUSquaredDifferencesMetric::getTargetValues()
 {
-    return &myRefData;
+    resizeData();
+    return myTargetData;
 }
 
 /**
  * @brief Gets the value count for SSD metric
  * @return Values count
  *
- * In case of SSD metric the values count is equal to 1
+ * In case of SSD metric the values count is equal to 1 or to the number of tiles
  *
  */
 int TCPUSquaredDifferencesMetric::valuesCount() const
 {
-    return 1;
+    const QSize tiles = getTilesCount();
+    return tiles.width() * tiles.height();
+}
+
+/**
+ * @brief Gets size of the rendered image
+ * @return Size of the rendered image
+ */
+QSize TCPUSquaredDifferencesMetric::getFrameSize() const
+{
+    return myOriginalSize;
 }
 
 /**
@@ -86,4 +363,7 @@ int TCPUSquaredDifferencesMetric::valuesCount() const
  */
 TCPUSquaredDifferencesMetric::~TCPUSquaredDifferencesMetric()
 {
+    delete[] myRefData;
+    delete[] myData;
+    delete[] myTargetData;
 }
@@ -19,13 +19,22 @@
 
 #include "ImageMetric/timagemetric.h"
 
+#include <random>
+#include <algorithm>
+#include <math.h>
+
 /**
  * @brief Default constructor of TImageMetric class
  * @param renderer Pointer to the shared parent renderer
  */
-TImageMetric::TImageMetric(SSIMRenderer::OffscreenRenderer *renderer):
+TImageMetric::TImageMetric(TRenderer * renderer):
+    mySampling(FullSampling),
+    mySampleCount(0),
+    mySampleSeed(0),
+    mySampleIteration(0),
     myRenderer(renderer),
-    myObserver(0)
+    myObserver(0),
+    myWorkerPool(0)
 {    
 }
 
@@ -45,6 +54,64 @@ void TImageMetric::setHistogramBinsCount(int count)
 {
 }
 
+/**
+ * @brief Computes the normalized mutual information from the joint histogram
+ * @param[in] histogram Joint histogram, the rows belong to the original radiograph
+ * @param[in] bins Number of bins of each image
+ * @param[in] n Number of pixels
+ * @return NMI = (H(A) + H(B)) / H(A, B), 2 for an empty histogram
+ */
+float TImageMetric::normalizedMutualInformation(const float * histogram, int bins, int n)
+{
+    double joint = 0.0;
+    QVector<double> a(bins, 0.0);
+    QVector<double> b(bins, 0.0);
+    for(int i = 0; i < bins; i++)
+    {
+        for(int j = 0; j < bins; j++)
+        {
+            const double p = double(histogram[i * bins + j]) / n;
+            if(p > 0.0)
+                joint -= p * log(p);
+            a[i] += p;
+            b[j] += p;
+        }
+    }
+
+    double entropy = 0.0;
+    for(int i = 0; i < bins; i++)
+    {
+        if(a.at(i) > 0.0)
+            entropy -= a.at(i) * log(a.at(i));
+        if(b.at(i) > 0.0)
+            entropy -= b.at(i) * log(b.at(i));
+    }
+
+    return joint > 0.0 ? entropy / joint : 2;
+}
+
+/**
+ * @brief Gets positions of the metric values in the rendered image
+ * @return Array of pixel indices for each value, null pointer if the values are not pixels
+ *
+ * Metrics computing one value per pixel provide the index of the pixel
+ * in the rendered image buffer for each of their values.
+ *
+ */
+const int * TImageMetric::getPixelIndices() const
+{
+    return NULL;
+}
+
+/**
+ * @brief Gets size of the rendered image buffer read by the metric
+ * @return Size of the rendered image
+ */
+QSize TImageMetric::getFrameSize() const
+{
+    return QSize();
+}
+
 /**
  * @brief Sets a mask of ignored points
  * @param mask
@@ -52,3 +119,136 @@ void TImageMetric::setHistogramBinsCount(int count)
 void TImageMetric::setMask(const QImage & mask)
 {
 }
+
+/**
+ * @brief Sets the selection of the pixels providing the metric values
+ * @param type Sampling type
+ * @param count Number of the selected pixels, all the pixels are used if 0
+ * @param seed Seed of the random and Halton sequences
+ *
+ * Metrics computing one value per pixel return only the values
+ * and target values of the selected pixels.
+ *
+ */
+void TImageMetric::setSampling(SamplingType type, int count, unsigned int seed)
+{
+    mySampling    = type;
+    mySampleCount = count;
+    mySampleSeed  = seed;
+    resample(0);
+}
+
+/**
+ * @brief Selects the pixels again
+ * @param iteration Index of the selection, metrics selecting the same iteration select the same pixels
+ */
+void TImageMetric::resample(unsigned int iteration)
+{
+    mySampleIteration = iteration;
+}
+
+/**
+ * @brief Computes the radical inverse of an integer
+ * @param i Integer
+ * @param base Base of the radical inverse
+ * @return Radical inverse in range [0, 1)
+ */
+static double radicalInverse(unsigned int i, unsigned int base)
+{
+    double result = 0;
+    double f = 1.0 / base;
+    while(i > 0)
+    {
+        result += f * (i % base);
+        i /= base;
+        f /= base;
+    }
+    return result;
+}
+
+/**
+ * @brief Selects a subset of the candidate pixels according to the sampling settings
+ * @param candidates Ascending indices of the candidate pixels in the rendered image
+ * @param n Number of the candidate pixels
+ * @param iteration Index of the selection
+ * @return Ascending positions of the selected pixels in the candidates array
+ */
+QVector<int> TImageMetric::selectSamples(const int * candidates, int n, unsigned int iteration) const
+{
+    QVector<int> samples;
+
+    if(mySampling == FullSampling || mySampleCount <= 0 || mySampleCount >= n)
+    {
+        samples.resize(n);
+        for(int i = 0; i < n; i++)
+            samples[i] = i;
+        return samples;
+    }
+
+    const int m = mySampleCount;
+    std::mt19937 generator(mySampleSeed * 2654435761u + iteration);
+
+    switch(mySampling)
+    {
+    case RandomSampling:
+    {
+        // Partial Fisher-Yates shuffle
+        std::vector<int> positions(n);
+        for(int i = 0; i < n; i++)
+            positions[i] = i;
+        for(int i = 0; i < m; i++)
+        {
+            std::uniform_int_distribution<int> distribution(i, n - 1);
+            std::swap(positions[i], positions[distribution(generator)]);
+        }
+        samples.reserve(m);
+        for(int i = 0; i < m; i++)
+            samples.push_back(positions[i]);
+        std::sort(samples.begin(), samples.end());
+        break;
+    }
+    case StratifiedSampling:
+    {
+        samples.reserve(m);
+        for(int s = 0; s < m; s++)
+        {
+            const int begin = (long long) s * n / m;
+            const int end   = (long long) (s + 1) * n / m;
+            std::uniform_int_distribution<int> distribution(begin, end - 1);
+            samples.push_back(distribution(generator));
+        }
+        break;
+    }
+    case HaltonSampling:
+    {
+        // Points of the 2D Halton sequence mapped to the pixels, masked pixels are skipped
+        const QSize frame = getFrameSize();
+        QVector<bool> selected(n, false);
+        samples.reserve(m);
+        const unsigned int last = mySampleSeed + 1 + 16 * (unsigned int) n;
+        for(unsigned int i = mySampleSeed + 1; i < last && samples.size() < m; i++)
+        {
+            const int x = radicalInverse(i, 2) * frame.width();
+            const int y = radicalInverse(i, 3) * frame.height();
+            const int pixel = y * frame.width() + x;
+
+            const int * found = std::lower_bound(candidates, candidates + n, pixel);
+            if(found == candidates + n || *found != pixel)
+                continue;
+
+            const int position = found - candidates;
+            if(!selected[position])
+            {
+                selected[position] = true;
+                samples.push_back(position);
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+        break;
+    }
+    default:
+        break;
+    }
+
+    return samples;
+}
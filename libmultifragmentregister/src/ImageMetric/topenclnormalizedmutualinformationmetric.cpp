@@ -23,12 +23,12 @@
 
 /**
  * @brief Constructor of TOpenCLNormalizedMutualInformationMetric class
- * @param renderer Pointer to the shared parent renderer
+ * @param renderer Pointer to the shared parent renderer, requires the OpenGL backend
  */
 TOpenCLNormalizedMutualInformationMetric::
-TOpenCLNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TOpenCLNormalizedMutualInformationMetric(TRenderer * renderer):
     TImageMetric(renderer),
-    nmiComputing(new SSIMRenderer::NMIComputingOpenCL(64, renderer))
+    nmiComputing(new SSIMRenderer::NMIComputingOpenCL(64, renderer->getOffscreenRenderer()))
 {
     myRefData = 2;
 }
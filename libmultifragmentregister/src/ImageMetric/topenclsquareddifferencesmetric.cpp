@@ -23,12 +23,12 @@
 
 /**
  * @brief Constructor of TOpenCLSquaredDifferencesMetric class
- * @param renderer Pointer to the shared parent renderer
+ * @param renderer Pointer to the shared parent renderer, requires the OpenGL backend
  */
 TOpenCLSquaredDifferencesMetric::
-TOpenCLSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TOpenCLSquaredDifferencesMetric(TRenderer * renderer):
     TImageMetric(renderer),
-    mySSDComputing(new SSIMRenderer::SSDComputingOpenCL(renderer))
+    mySSDComputing(new SSIMRenderer::SSDComputingOpenCL(renderer->getOffscreenRenderer()))
 {
     myRefData = 0;
 }
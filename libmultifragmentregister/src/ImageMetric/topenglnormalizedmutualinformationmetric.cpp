@@ -21,12 +21,12 @@
 
 /**
  * @brief Constructor of TOpenGLNormalizedMutualInformationMetric class
- * @param renderer Pointer to the shared parent renderer
+ * @param renderer Pointer to the shared parent renderer, requires the OpenGL backend
  */
 TOpenGLNormalizedMutualInformationMetric::
-TOpenGLNormalizedMutualInformationMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TOpenGLNormalizedMutualInformationMetric(TRenderer * renderer):
     TImageMetric(renderer),
-    nmiComputing(new SSIMRenderer::NMIComputingOpenGL(64, renderer))
+    nmiComputing(new SSIMRenderer::NMIComputingOpenGL(64, renderer->getOffscreenRenderer()))
 {
     myRefData = 2;
 }
@@ -21,12 +21,12 @@
 
 /**
  * @brief Constructor of TOpenGLSquaredDifferencesMetric class
- * @param renderer Pointer to the shared parent renderer
+ * @param renderer Pointer to the shared parent renderer, requires the OpenGL backend
  */
 TOpenGLSquaredDifferencesMetric::
-TOpenGLSquaredDifferencesMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TOpenGLSquaredDifferencesMetric(TRenderer * renderer):
     TImageMetric(renderer),
-    mySSDComputing(new SSIMRenderer::SSDComputingOpenGL(renderer))
+    mySSDComputing(new SSIMRenderer::SSDComputingOpenGL(renderer->getOffscreenRenderer()))
 {
     myRefData = 0;
 }
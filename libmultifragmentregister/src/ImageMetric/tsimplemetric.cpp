@@ -18,7 +18,9 @@
  */
 
 #include "ImageMetric/tsimplemetric.h"
+#include "timagereader.h"
 #include <vector>
+#include <algorithm>
 #include <assert.h>
 
 /**
@@ -26,12 +28,15 @@
  * @param renderer Pointer to the shared parent renderer
  */
 TSimpleMetric::
-TSimpleMetric(SSIMRenderer::OffscreenRenderer * renderer):
+TSimpleMetric(TRenderer * renderer):
     TImageMetric(renderer),
     myData(0),
-    myOriginalData(0),
     myRefData(0),
-    myN(0)
+    myAllRefData(0),
+    myIndices(0),
+    myAllIndices(0),
+    myN(0),
+    myAllN(0)
 {
 }
 
@@ -44,26 +49,51 @@ void TSimpleMetric::setImage(const QImage & image)
     myOriginalSize = image.size();
     myImage = image; //.copy(myCrop);
 
+    if(myAllRefData != 0)
+    {
+        delete[] myAllRefData;
+        delete[] myAllIndices;
+    }
+
+    myAllN = myImage.width() * myImage.height();
+    myAllRefData = new float[myAllN];
+    myAllIndices = new int[myAllN];
+    for(int i = 0; i < myAllN; i++)
+        myAllIndices[i] = i;
+
+    TImageReader::readRed(myImage, myAllRefData);
+
+    resample(mySampleIteration);
+}
+
+/**
+ * @brief Selects the pixels providing the metric values
+ * @param iteration Index of the selection
+ */
+void TSimpleMetric::resample(unsigned int iteration)
+{
+    TImageMetric::resample(iteration);
+    if(myAllIndices == 0)
+        return;
+
+    const QVector<int> samples = selectSamples(myAllIndices, myAllN, iteration);
+
     if(myData != 0)
     {
         delete[] myData;
-        delete[] myOriginalData;
         delete[] myRefData;
+        delete[] myIndices;
     }
 
-    myN = myImage.width() * myImage.height();
+    myN = samples.size();
     myData    = new float[myN];
-    //myOriginalData = new float[myOriginalSize.width() * myOriginalSize.height()];
     myRefData = new float[myN];
-
-    QImage mirrored = myImage.mirrored();
-
-    unsigned int i = 0;
-    for(int row = 0; row < mirrored.height(); row++)
-        for(int col = 0; col < mirrored.width(); col++)
-            myRefData[i++] = qRed(mirrored.pixel(col, row)) / 255.0;
-
-    //*myRefData = 0;
+    myIndices = new int[myN];
+    for(int k = 0; k < myN; k++)
+    {
+        myIndices[k] = myAllIndices[samples.at(k)];
+        myRefData[k] = myAllRefData[samples.at(k)];
+    }
 }
 
 /**
@@ -71,7 +101,9 @@ void TSimpleMetric::setImage(const QImage & image)
  * @return simple metric value
  *
  * In case of simple metric the values are equal to the rendered image mask
- * rearranged to a vector
+ * rearranged to a vector. The values are gathered directly from the buffer
+ * of the renderer, only the bounds of the rendered fragment reported by the
+ * renderer are read.
  *
  */
 float * TSimpleMetric::getValues()
@@ -81,25 +113,34 @@ float * TSimpleMetric::getValues()
     if(myObserver != NULL)
         myObserver->beforeMetric();
 
-    myRenderer->getRenderedRedChannel(myOriginalData);
-
-    int top    = 0; // myOriginalSize.height() - myCrop.bottomLeft().y() - 1;
-    int bottom = myOriginalSize.height(); //myOriginalSize.height() - myCrop.topLeft().y();
-    int left   = 0; //myCrop.topLeft().x();
-    int right  = myOriginalSize.width(); //myCrop.topRight().x() + 1;
-
-    unsigned int i = 0;
-    for(int y = top; y < bottom; y++)
-        for(int x = left; x < right; x++)
-            myData[i++] = myOriginalData[y * myOriginalSize.width() + x];
-
-    assert(i == myN);
+    // Only the bounds of the rendered fragment are read, the rest is zero
+    const QRect bounds = myRenderer->getRenderedBounds();
+    const int w = myOriginalSize.width();
+    if(bounds.isEmpty())
+        std::fill(myData, myData + myN, 0.0f);
+    else
+    {
+        int stride = 0;
+        const float * image = myRenderer->getRenderedRedChannelBuffer(stride);
+        if(bounds.size() == myOriginalSize && stride == w)
+        {
+            for(int k = 0; k < myN; k++)
+                myData[k] = image[myIndices[k]];
+        }
+        else
+        {
+            for(int k = 0; k < myN; k++)
+            {
+                const int x = myIndices[k] % w;
+                const int y = myIndices[k] / w;
+                myData[k] = bounds.contains(x, y) ? image[y * stride + x] : 0.0f;
+            }
+        }
+    }
 
     if(myObserver != NULL)
         myObserver->afterMetric();
 
-    delete[] myOriginalData;
-    //*myData = 0;
     return myData;
 }
 
@@ -116,12 +157,31 @@ float * TSimpleMetric::getTargetValues()
     return myRefData;
 }
 
+/**
+ * @brief Gets positions of the metric values in the rendered image
+ * @return Array of pixel indices
+ */
+const int * TSimpleMetric::getPixelIndices() const
+{
+    return myIndices;
+}
+
+/**
+ * @brief Gets size of the rendered image
+ * @return Size of the rendered image
+ */
+QSize TSimpleMetric::getFrameSize() const
+{
+    return myOriginalSize;
+}
+
 /**
  * @brief Gets the value count for the simple metric
  * @return Values count
  *
  * In case of simple metric the values count is equal
- * to width*height of the original radiograph
+ * to width*height of the original radiograph or to the number
+ * of the selected pixels, see setSampling()
  *
  */
 int TSimpleMetric::valuesCount() const
@@ -18,7 +18,9 @@
  */
 
 #include "ImageMetric/tsimplemetricmask.h"
+#include "timagereader.h"
 #include <vector>
+#include <algorithm>
 #include <assert.h>
 
 /**
@@ -26,13 +28,16 @@
  * @param renderer Pointer to the shared parent renderer
  */
 TSimpleMetricMask::
-TSimpleMetricMask(SSIMRenderer::OffscreenRenderer * renderer):
+TSimpleMetricMask(TRenderer * renderer):
     TImageMetric(renderer),
     myData(0),
-    myOriginalData(0),
     myRefData(0),
+    myAllRefData(0),
+    myIndices(0),
+    myAllIndices(0),
     myMaskData(0),
-    myN(0)
+    myN(0),
+    myAllN(0)
 {
 }
 
@@ -49,24 +54,9 @@ void TSimpleMetricMask::setMask(const QImage & mask)
 
     int n = mask.width() * mask.height();
     myMaskData = new bool[n];
-    QImage mirrored = mask.mirrored();
+    TImageReader::readRedMask(mask, 0, myMaskData);
 
-    unsigned int i = 0;
-    unsigned int k = 0;
-    for(int row = 0; row < mirrored.height(); row++)
-    {
-        for(int col = 0; col < mirrored.width(); col++)
-        {
-            myMaskData[i] = qRed(mirrored.pixel(col, row)) > 0;
-            if(!myMaskData[i])
-            {
-                k++;
-            }
-            i++;
-        }
-    }
-
-    myN = k;
+    myAllN = n - std::count(myMaskData, myMaskData + n, true);
 }
 
 /**
@@ -78,30 +68,84 @@ void TSimpleMetricMask::setImage(const QImage & image)
     myOriginalSize = image.size();
     myImage = image;
 
+    if(myAllRefData != 0)
+    {
+        delete[] myAllRefData;
+        delete[] myAllIndices;
+    }
+
+    myAllRefData = new float[myAllN];
+    myAllIndices = new int[myAllN];
+
+    const int n = image.width() * image.height();
+    std::vector<float> values(n);
+    TImageReader::readRed(image, values.data());
+
+    int k = 0;
+    for(int i = 0; i < n; i++)
+    {
+        if(!myMaskData[i])
+        {
+            myAllIndices[k]   = i;
+            myAllRefData[k++] = values[i];
+        }
+    }
+
+    resample(mySampleIteration);
+}
+
+/**
+ * @brief Selects the unmasked pixels providing the metric values
+ * @param iteration Index of the selection
+ */
+void TSimpleMetricMask::resample(unsigned int iteration)
+{
+    TImageMetric::resample(iteration);
+    if(myAllIndices == 0)
+        return;
+
+    const QVector<int> samples = selectSamples(myAllIndices, myAllN, iteration);
+
     if(myData != 0)
     {
         delete[] myData;
-        delete[] myOriginalData;
         delete[] myRefData;
+        delete[] myIndices;
     }
 
-    //myN = myImage.width() * myImage.height();
+    myN = samples.size();
     myData    = new float[myN];
     myRefData = new float[myN];
+    myIndices = new int[myN];
+    for(int k = 0; k < myN; k++)
+    {
+        myIndices[k] = myAllIndices[samples.at(k)];
+        myRefData[k] = myAllRefData[samples.at(k)];
+    }
 
-    QImage mirrored = myImage.mirrored();
+    updateSpans();
+}
+
+/**
+ * @brief Splits the selected pixels into runs of consecutive pixels
+ *
+ * Each span holds the index of its first pixel and its length, the runs
+ * do not cross the rows. The values of the consecutive pixels of a row
+ * are copied at once, the cost therefore depends on the unmasked area only.
+ *
+ */
+void TSimpleMetricMask::updateSpans()
+{
+    const int w = myOriginalSize.width();
 
-    unsigned int i = 0;
-    unsigned int k = 0;
-    for(int row = 0; row < mirrored.height(); row++)
+    mySpans.clear();
+    for(int k = 0; k < myN; k++)
     {
-        for(int col = 0; col < mirrored.width(); col++)
-        {
-            if(!myMaskData[i++])
-            {
-                myRefData[k++] = qRed(mirrored.pixel(col, row)) / 255.0;
-            }
-        }
+        const int i = myIndices[k];
+        if(!mySpans.isEmpty() && mySpans.last().first + mySpans.last().second == i && i % w != 0)
+            mySpans.last().second++;
+        else
+            mySpans.append(qMakePair(i, 1));
     }
 }
 
@@ -110,7 +154,8 @@ void TSimpleMetricMask::setImage(const QImage & image)
  * @return simple metric value
  *
  * In case of simple metric the values are equal to the rendered image mask
- * rearranged to a vector
+ * rearranged to a vector. The values are copied by the runs of the unmasked
+ * pixels, see updateSpans().
  *
  */
 float * TSimpleMetricMask::getValues()
@@ -118,35 +163,23 @@ float * TSimpleMetricMask::getValues()
     if(myObserver != NULL)
         myObserver->beforeMetric();
 
-    myRenderer->getRenderedRedChannel(myOriginalData);
+    int stride = 0;
+    const float * image = myRenderer->getRenderedRedChannelBuffer(stride);
 
-    int top    = 0;
-    int bottom = myOriginalSize.height();
-    int left   = 0;
-    int right  = myOriginalSize.width();
-
-    unsigned int i = 0;
-    unsigned int k = 0;
-    for(int y = top; y < bottom; y++)
+    const int w = myOriginalSize.width();
+    float * data = myData;
+    for(int s = 0; s < mySpans.size(); s++)
     {
-        for(int x = left; x < right; x++)
-        {
-            if(!myMaskData[i++]) {
-                myData[k++] = myOriginalData[y * myOriginalSize.width() + x];
-            }
-            /*
-            else {
-                myData[i] = myRefData[i];
-            }*/
-        }
+        const int i = mySpans.at(s).first;
+        const int n = mySpans.at(s).second;
+        const float * row = image + (i / w) * stride + i % w;
+        std::copy(row, row + n, data);
+        data += n;
     }
 
-    assert(k == myN);
-
     if(myObserver != NULL)
         myObserver->afterMetric();
 
-    delete[] myOriginalData;
     return myData;
 }
 
@@ -163,6 +196,24 @@ float * TSimpleMetricMask::getTargetValues()
     return myRefData;
 }
 
+/**
+ * @brief Gets positions of the metric values in the rendered image
+ * @return Array of pixel indices of the unmasked pixels
+ */
+const int * TSimpleMetricMask::getPixelIndices() const
+{
+    return myIndices;
+}
+
+/**
+ * @brief Gets size of the rendered image
+ * @return Size of the rendered image
+ */
+QSize TSimpleMetricMask::getFrameSize() const
+{
+    return myOriginalSize;
+}
+
 /**
  * @brief Gets the value count for the simple metric
  * @return Values count
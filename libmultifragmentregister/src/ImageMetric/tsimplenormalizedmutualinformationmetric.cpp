@@ -0,0 +1,130 @@
+/**
+ * @file        tsimplenormalizedmutualinformationmetric.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TSimpleNormalizedMutualInformationMetric class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "ImageMetric/tsimplenormalizedmutualinformationmetric.h"
+#include "timagereader.h"
+
+/**
+ * @brief Constructor of TSimpleNormalizedMutualInformationMetric class
+ * @param renderer Pointer to the shared parent renderer
+ */
+TSimpleNormalizedMutualInformationMetric::
+TSimpleNormalizedMutualInformationMetric(TRenderer * renderer):
+    TImageMetric(renderer),
+    myBinsCount(64),
+    myData(0),
+    myRefData(2)
+{
+}
+
+/**
+ * @brief Sets the histogram bins count for the NMI metric
+ * @param count Bins count
+ */
+void TSimpleNormalizedMutualInformationMetric::setHistogramBinsCount(int count)
+{
+    myBinsCount = count;
+    updateBins();
+}
+
+/**
+ * @brief Sets the original radiograph image
+ * @param image Radiograph image
+ */
+void TSimpleNormalizedMutualInformationMetric::setImage(const QImage & image)
+{
+    myImage.resize(image.width() * image.height());
+    TImageReader::readRed(image, myImage.data());
+
+    updateBins();
+}
+
+/**
+ * @brief Quantizes the original radiograph into the histogram bins
+ */
+void TSimpleNormalizedMutualInformationMetric::updateBins()
+{
+    myImageBins.resize(myImage.size());
+    for(int i = 0; i < myImage.size(); i++)
+        myImageBins[i] = qBound(0, int(myImage.at(i) * myBinsCount), myBinsCount - 1);
+}
+
+/**
+ * @brief Get current value of NMI metric
+ * @return NMI metric value
+ *
+ * NMI = (H(A) + H(B)) / H(A, B), the entropies are given by the joint
+ * histogram of the original and the rendered radiograph.
+ *
+ */
+float * TSimpleNormalizedMutualInformationMetric::getValues()
+{
+    if(myObserver != NULL)
+        myObserver->beforeMetric();
+
+    float * data = NULL;
+    myRenderer->getRenderedRedChannel(data);
+
+    const int n = myImageBins.size();
+    myHistogram.fill(0, myBinsCount * myBinsCount);
+    for(int i = 0; i < n; i++)
+    {
+        const int bin = qBound(0, int(data[i] * myBinsCount), myBinsCount - 1);
+        myHistogram[myImageBins.at(i) * myBinsCount + bin]++;
+    }
+    delete[] data;
+
+    myData = normalizedMutualInformation(myHistogram.constData(), myBinsCount, n);
+
+    if(myObserver != NULL)
+        myObserver->afterMetric();
+
+    return &myData;
+}
+
+/**
+ * @brief Gets target values for the NMI metric
+ * @return NMI target value
+ *
+ * In case of NMI metric the target value is equal to 2
+ *
+ */
+float * TSimpleNormalizedMutualInformationMetric::getTargetValues()
+{
+    return &myRefData;
+}
+
+/**
+ * @brief Gets the value count for NMI metric
+ * @return Values count
+ *
+ * In case of NMI metric the values count is equal to 1
+ *
+ */
+int TSimpleNormalizedMutualInformationMetric::valuesCount() const
+{
+    return 1;
+}
+
+/**
+ * @brief Destructor of TSimpleNormalizedMutualInformationMetric class
+ */
+TSimpleNormalizedMutualInformationMetric::~TSimpleNormalizedMutualInformationMetric()
+{
+}
@@ -19,6 +19,7 @@
 
 #include "Observer/tdefaultobserver.h"
 #include <QTime>
+#include <QMutexLocker>
 #include <QDebug>
 #include <iostream>
 #include <QDir>
@@ -79,7 +80,9 @@ void TDefaultObserver::shapeChanged(const QVector<float> & shape)
  */
 void TDefaultObserver::beforeRendering()
 {
-    myRenderingTimer.start();
+    myRenderingTimer.localData().start();
+
+    QMutexLocker locker(&myMutex);
     myRenderedImages++;
 }
 
@@ -88,7 +91,10 @@ void TDefaultObserver::beforeRendering()
  */
 void TDefaultObserver::afterRendering()
 {
-    myRenderingTime += myRenderingTimer.elapsed();
+    int elapsed = myRenderingTimer.localData().elapsed();
+
+    QMutexLocker locker(&myMutex);
+    myRenderingTime += elapsed;
 }
 
 /**
@@ -96,7 +102,9 @@ void TDefaultObserver::afterRendering()
  */
 void TDefaultObserver::beforeMetric()
 {
-    myMetricTimer.start();
+    myMetricTimer.localData().start();
+
+    QMutexLocker locker(&myMutex);
     myMetricsComputed++;
 }
 
@@ -105,7 +113,10 @@ void TDefaultObserver::beforeMetric()
  */
 void TDefaultObserver::afterMetric()
 {
-    myMetricTime += myMetricTimer.elapsed();
+    int elapsed = myMetricTimer.localData().elapsed();
+
+    QMutexLocker locker(&myMutex);
+    myMetricTime += elapsed;
 }
 
 /**
@@ -118,11 +129,15 @@ void TDefaultObserver::beforeRegistration()
 }
 
 /**
- * @brief TDefaultObserver::afterRegistration
+ * @brief Stops the registration timer and records the counts of renders and iterations so far
  */
 void TDefaultObserver::afterRegistration()
 {
     myRegistrationTime += myRegistrationTimer.elapsed();
+
+    QMutexLocker locker(&myMutex);
+    myRegistrationRenderedCounts << myRenderedImages;
+    myRegistrationIterations << myIterations;
 }
 
 /**
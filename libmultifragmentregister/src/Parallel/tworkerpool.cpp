@@ -0,0 +1,77 @@
+/**
+ * @file        tworkerpool.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TWorkerPool class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "Parallel/tworkerpool.h"
+
+#include <QSemaphore>
+#include <assert.h>
+
+/**
+ * @brief Constructor of TWorkerPool class
+ * @param[in] count Number of worker threads, the calling thread is not included
+ */
+TWorkerPool::TWorkerPool(int count) :
+    myCount(qMax(0, count)),
+    myNext(0)
+{
+}
+
+/**
+ * @brief Destructor of TWorkerPool class, finishes the queued tasks
+ */
+TWorkerPool::~TWorkerPool()
+{
+    qDeleteAll(myWorkers);
+}
+
+/**
+ * @brief Executes the tasks and waits until they are finished
+ * @param[in] count Number of tasks, at most size()
+ * @param[in] task Function receiving the index of the task
+ *
+ * The task 0 is executed by the calling thread, the others are spread
+ * among the worker threads starting by the one following the worker
+ * used by the previous job.
+ *
+ */
+void TWorkerPool::
+run(int count, const std::function<void(int)> & task)
+{
+    assert(count <= size());
+
+    if(count > 1)
+    {
+        QMutexLocker locker(&myMutex);
+        while(myWorkers.size() < myCount)
+            myWorkers.append(new TWorkerThread);
+    }
+
+    QSemaphore done;
+    const int first = myNext.fetchAndAddOrdered(count - 1);
+    for(int i = 1; i < count; i++)
+    {
+        myWorkers[(unsigned int)(first + i) % myCount]->post([&task, &done, i]() {
+            task(i);
+            done.release();
+        });
+    }
+
+    task(0);
+    done.acquire(count - 1);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file        tworkerthread.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TWorkerThread class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "Parallel/tworkerthread.h"
+
+/**
+ * @brief Constructor of TWorkerThread class, the thread is started immediately
+ * @param[in] parent Parent object
+ */
+TWorkerThread::TWorkerThread(QObject * parent) :
+    QThread(parent),
+    myPending(0),
+    myStopped(false)
+{
+    start();
+}
+
+/**
+ * @brief Destructor of TWorkerThread class
+ *
+ * Finishes all queued jobs and stops the thread.
+ */
+TWorkerThread::~TWorkerThread()
+{
+    myMutex.lock();
+    myStopped = true;
+    myJobPosted.wakeAll();
+    myMutex.unlock();
+    wait();
+}
+
+/**
+ * @brief Appends the job to the queue of the thread
+ * @param[in] job Function to be executed in the worker thread
+ */
+void TWorkerThread::
+post(const std::function<void()> & job)
+{
+    QMutexLocker locker(&myMutex);
+    myJobs.enqueue(job);
+    myPending++;
+    myJobPosted.wakeOne();
+}
+
+/**
+ * @brief Blocks the calling thread until all posted jobs are finished
+ */
+void TWorkerThread::
+waitForDone()
+{
+    QMutexLocker locker(&myMutex);
+    while(myPending > 0)
+        myJobsDone.wait(&myMutex);
+}
+
+/**
+ * @brief Executes the job in the worker thread and waits for its result
+ * @param[in] job Function to be executed in the worker thread
+ */
+void TWorkerThread::
+execute(const std::function<void()> & job)
+{
+    post(job);
+    waitForDone();
+}
+
+/**
+ * @brief Main loop of the worker thread
+ */
+void TWorkerThread::
+run()
+{
+    forever
+    {
+        std::function<void()> job;
+        {
+            QMutexLocker locker(&myMutex);
+            while(myJobs.isEmpty() && !myStopped)
+                myJobPosted.wait(&myMutex);
+
+            if(myJobs.isEmpty())
+                return;
+
+            job = myJobs.dequeue();
+        }
+
+        job();
+
+        QMutexLocker locker(&myMutex);
+        myPending--;
+        if(myPending == 0)
+            myJobsDone.wakeAll();
+    }
+}
@@ -0,0 +1,259 @@
+/**
+ * @file        tmodeldata.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TModelData class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "Renderer/tmodeldata.h"
+
+#include <QDebug>
+#include <assert.h>
+
+/**
+ * @brief Number of incremental shape updates between two full recomputations of the vertices
+ */
+static const int RecomputeInterval = 32;
+
+/**
+ * @brief Default constructor of TModelData class
+ */
+TModelData::TModelData():
+    myDensityFile(NULL),
+    myUpdates(0),
+    myVersion(0)
+{
+}
+
+/**
+ * @brief Copies the vertices and triangles of the mesh
+ * @param[in] mesh Polygonal or tetrahedral mesh
+ *
+ * The vertices are read by Mesh::getVertices2DVector(), the counterpart
+ * of Mesh::getTriangles2DVector() returning one vector of coordinates
+ * per vertex, the tetrahedra by Mesh::getTetrahedra2DVector().
+ *
+ */
+void TModelData::
+setMesh(SSIMRenderer::Mesh * mesh)
+{
+    assert(mesh != NULL);
+
+    myTriangles = mesh->getTriangles2DVector();
+    myTetrahedra.clear();
+    if(mesh->getNumberOfTetrahedra() > 0)
+        myTetrahedra = mesh->getTetrahedra2DVector();
+
+    const QVector<QVector<float> > vertices = mesh->getVertices2DVector();
+    myMeanVertices.resize(vertices.size());
+    for(int i = 0; i < vertices.size(); i++)
+        myMeanVertices[i] = QVector3D(vertices.at(i).at(0), vertices.at(i).at(1), vertices.at(i).at(2));
+
+    myModes.clear();
+    myScores.clear();
+    myStd.clear();
+    updateVertices();
+    updateDensities();
+}
+
+/**
+ * @brief Copies the statistical shape model
+ * @param[in] shapeFile Shape model
+ *
+ * The shape model stores the mean shape by StatisticalData::getMeanMatrix()
+ * as x, y, z triplets and the modes by StatisticalData::getEigenvectorsMatrix()
+ * one mode after another, both in the vertex order of the mesh. The scores
+ * and the standard deviations are the same as used by the OpenGL renderer.
+ *
+ */
+void TModelData::
+setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile)
+{
+    assert(shapeFile != NULL);
+    assert(!myMeanVertices.isEmpty());
+
+    const int nv = myMeanVertices.size();
+    const int n  = shapeFile->getNumberOfParameters();
+
+    for(int i = 0; i < nv; i++)
+        myMeanVertices[i] = QVector3D(shapeFile->getMeanMatrix()[i * 3 + 0],
+                                      shapeFile->getMeanMatrix()[i * 3 + 1],
+                                      shapeFile->getMeanMatrix()[i * 3 + 2]);
+
+    myModes.resize(n * nv * 3);
+    for(int i = 0; i < myModes.size(); i++)
+        myModes[i] = shapeFile->getEigenvectorsMatrix()[i];
+
+    myScores.resize(n);
+    myStd.resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        myScores[i] = shapeFile->getPcsMatrix()[i];
+        myStd[i]    = shapeFile->getStdMatrix()[i];
+    }
+
+    updateVertices();
+}
+
+/**
+ * @brief Sets the density model
+ * @param[in] densityFile Density model
+ */
+void TModelData::
+setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile)
+{
+    myDensityFile = densityFile;
+    updateDensities();
+}
+
+/**
+ * @brief Gets the number of the shape model parameters
+ * @return Number of parameters
+ */
+int TModelData::
+getShapeParamsCount() const
+{
+    return myScores.size();
+}
+
+/**
+ * @brief Gets a shape parameter
+ * @param[in] i Index of the parameter
+ * @return Principal component score
+ */
+float TModelData::
+getShapeParam(int i) const
+{
+    return myScores.at(i);
+}
+
+/**
+ * @brief Gets the standard deviation of a shape parameter
+ * @param[in] i Index of the parameter
+ * @return Standard deviation
+ */
+float TModelData::
+getShapeStd(int i) const
+{
+    return myStd.at(i);
+}
+
+/**
+ * @brief Sets the shape parameters and updates the vertices
+ * @param[in] scores Principal component scores, the remaining parameters are kept
+ *
+ * If only a few scores change, e.g. a single one in the finite differences
+ * of the shape gradient, the vertices are updated by delta * mode of the
+ * changed scores in O(nv) each instead of being recomputed from all modes.
+ * The vertices are recomputed after every RecomputeInterval incremental
+ * updates to bound the accumulated rounding error.
+ *
+ */
+void TModelData::
+setShapeParams(const QVector<float> & scores)
+{
+    assert(scores.size() <= myScores.size());
+
+    QVector<int> changed;
+    for(int i = 0; i < scores.size(); i++)
+        if(scores.at(i) != myScores.at(i))
+            changed << i;
+
+    if(changed.isEmpty())
+        return;
+
+    if(changed.size() * 2 > myScores.size() || myUpdates >= RecomputeInterval)
+    {
+        for(int i = 0; i < scores.size(); i++)
+            myScores[i] = scores.at(i);
+
+        updateVertices();
+        return;
+    }
+
+    const int nv = myMeanVertices.size();
+    foreach(int i, changed)
+    {
+        const float delta = scores.at(i) - myScores.at(i);
+        myScores[i] = scores.at(i);
+
+        const float * mode = myModes.constData() + i * nv * 3;
+        for(int j = 0; j < nv; j++)
+            myVertices[j] += delta * QVector3D(mode[j * 3 + 0], mode[j * 3 + 1], mode[j * 3 + 2]);
+    }
+    myUpdates++;
+    myVersion++;
+}
+
+/**
+ * @brief Recomputes the vertices of the current shape
+ */
+void TModelData::
+updateVertices()
+{
+    const int nv = myMeanVertices.size();
+    myVertices = myMeanVertices;
+    myUpdates = 0;
+    myVersion++;
+
+    for(int i = 0; i < myScores.size(); i++)
+    {
+        const float score = myScores.at(i);
+        if(score == 0.0f)
+            continue;
+
+        const float * mode = myModes.constData() + i * nv * 3;
+        for(int j = 0; j < nv; j++)
+            myVertices[j] += score * QVector3D(mode[j * 3 + 0], mode[j * 3 + 1], mode[j * 3 + 2]);
+    }
+}
+
+/**
+ * @brief Recomputes the densities of the tetrahedra
+ *
+ * The mean of the density model, StatisticalData::getMeanMatrix() of
+ * StatisticalData::getNumberOfValues() values, stores the coefficients
+ * of the Bernstein polynomials tetrahedron after tetrahedron. The mean
+ * of the coefficients of a Bernstein polynomial equals the mean of the
+ * polynomial over the tetrahedron and is used as its constant density.
+ *
+ */
+void TModelData::
+updateDensities()
+{
+    myDensities.clear();
+    if(myDensityFile == NULL || myTetrahedra.isEmpty())
+        return;
+
+    const int n = myTetrahedra.size();
+    const int values = myDensityFile->getNumberOfValues();
+    if(values < n || values % n != 0)
+    {
+        qDebug() << "WARNING: Density model of" << values << "values does not match" << n << "tetrahedra, the density is not rendered.";
+        return;
+    }
+
+    const int coefficients = values / n;
+
+    myDensities.resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        float sum = 0.0f;
+        for(int j = 0; j < coefficients; j++)
+            sum += myDensityFile->getMeanMatrix()[i * coefficients + j];
+
+        myDensities[i] = sum / coefficients;
+    }
+}
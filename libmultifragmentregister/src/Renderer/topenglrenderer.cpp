@@ -0,0 +1,479 @@
+/**
+ * @file        topenglrenderer.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TOpenGLRenderer class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "Renderer/topenglrenderer.h"
+
+/**
+ * @brief Constructor of TOpenGLRenderer class
+ * @param parent Renderer sharing its OpenGL context
+ */
+TOpenGLRenderer::TOpenGLRenderer(TOpenGLRenderer * parent):
+    myRoot(parent != NULL ? parent->myRoot : this),
+    myRenderer(new SSIMRenderer::OffscreenRenderer(512, 512, parent != NULL ? parent->myRenderer : NULL)),
+    mySize(512, 512),
+    myShapeVersion(0)
+{
+    setDefaultModes();
+}
+
+/**
+ * @brief Destructor of TOpenGLRenderer class
+ */
+TOpenGLRenderer::~TOpenGLRenderer()
+{
+    delete myRenderer;
+}
+
+/**
+ * @brief Gets the rendering backend
+ * @return OpenGL backend
+ */
+TRenderer::Backend TOpenGLRenderer::getBackend() const
+{
+    return OpenGLBackend;
+}
+
+/**
+ * @brief Gets the underlying OpenGL renderer
+ * @return Pointer to the OpenGL renderer
+ */
+SSIMRenderer::OffscreenRenderer * TOpenGLRenderer::getOffscreenRenderer()
+{
+    return myRenderer;
+}
+
+/**
+ * @brief Sets the rendering modes of a new renderer
+ *
+ * The polygonal model is rendered without lighting, the density, the
+ * silhouettes, the pyramid and the mirroring are disabled.
+ *
+ */
+void TOpenGLRenderer::setDefaultModes()
+{
+    myRenderer->enableXMirroring(false);
+    myRenderer->enableDensity(false);
+    myRenderer->enableSilhouettes(false);
+    myRenderer->enablePolygonal(true);
+    myRenderer->enablePyramid(false);
+    myRenderer->enablePolygonalLighting(false);
+    myRenderer->setIntensity(1.0f);
+    myRenderer->enableLogMessages(true);
+}
+
+/**
+ * @brief Restores the pose, the crop and the rendering modes of a new renderer
+ *
+ * The crop window is set to the whole radiograph, the rendering modes to
+ * their defaults, see setDefaultModes().
+ *
+ */
+void TOpenGLRenderer::reset()
+{
+    myRenderer->setCropWindow(QRect(QPoint(0, 0), mySize));
+    myCrop = QRect();
+    setDefaultModes();
+
+    if(myRoot == this)
+    {
+        myRenderer->setRotation(QVector3D());
+        myRenderer->setTranslation(QVector3D());
+    }
+}
+
+/**
+ * @brief Renders the virtual radiograph
+ */
+void TOpenGLRenderer::renderNow()
+{
+    myRenderer->renderNow();
+}
+
+/**
+ * @brief Gets the red channel of the rendered image
+ * @param data Pointer to the buffer allocated by the function, rows are stored bottom-up
+ */
+void TOpenGLRenderer::getRenderedRedChannel(float *& data)
+{
+    myRenderer->getRenderedRedChannel(data);
+}
+
+/**
+ * @brief Gets the rendered image
+ * @return Rendered image
+ */
+QImage TOpenGLRenderer::getRenderedImage()
+{
+    return myRenderer->getRenderedImage();
+}
+
+/**
+ * @brief Gets the size of the rendered image
+ * @return Size of the crop window, size of the whole radiograph if no crop is set
+ */
+QSize TOpenGLRenderer::getRenderedSize()
+{
+    return myCrop.isNull() ? mySize : myCrop.size();
+}
+
+/**
+ * @brief Gets the mask of the vertices visible in the radiograph
+ * @param vertices Buffer of vertices
+ * @param nv Number of vertices
+ * @return Vertices mask
+ */
+QVector<bool> TOpenGLRenderer::getVerticesMask(const float * vertices, int nv)
+{
+    return myRenderer->getVerticesMask(const_cast<float *>(vertices), nv);
+}
+
+/**
+ * @brief Gets the mask of the vertices inside a crop of the radiograph
+ * @param vertices Buffer of vertices
+ * @param nv Number of vertices
+ * @param crop Crop in OpenGL coordinates
+ * @param angle Angle of the crop
+ * @return Vertices mask
+ */
+QVector<bool> TOpenGLRenderer::getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle)
+{
+    return myRenderer->getVerticesMask(const_cast<float *>(vertices), nv, crop, angle);
+}
+
+/**
+ * @brief Gets the vertices of the current shape
+ * @param vertices Pointer to the buffer allocated by the function
+ * @param transformed Vertices are in the scene coordinates if set
+ * @return Number of vertices
+ */
+int TOpenGLRenderer::getRecomputedVertices(float *& vertices, bool transformed)
+{
+    return myRenderer->getRecomputedVertices(vertices, transformed);
+}
+
+/**
+ * @brief Gets the vertices of the current shape
+ * @param transformed Vertices are in the scene coordinates if set
+ * @return Vector of vertices
+ */
+QVector<QVector3D> TOpenGLRenderer::getRecomputedVertices(bool transformed)
+{
+    return myRenderer->getRecomputedVertices(transformed);
+}
+
+/**
+ * @brief Gets the number of vertices of the mesh
+ * @return Number of vertices
+ */
+int TOpenGLRenderer::getNumberOfVertices()
+{
+    return myRenderer->getMesh()->getNumberOfVertices();
+}
+
+/**
+ * @brief Gets the triangles of the mesh
+ * @return Vector of triangles, three vertex indices each
+ */
+QVector<QVector<unsigned int> > TOpenGLRenderer::getTriangles()
+{
+    return myRenderer->getMesh()->getTriangles2DVector();
+}
+
+/**
+ * @brief Sets the size of the whole radiograph
+ * @param width Width in pixels
+ * @param height Height in pixels
+ */
+void TOpenGLRenderer::setRenderSize(int width, int height)
+{
+    mySize = QSize(width, height);
+    myRenderer->setRenderSize(width, height);
+}
+
+/**
+ * @brief Sets the rendered part of the radiograph
+ * @param crop Crop in pixels
+ */
+void TOpenGLRenderer::setCropWindow(const QRect & crop)
+{
+    myCrop = crop;
+    myRenderer->setCropWindow(crop);
+}
+
+/**
+ * @brief Gets the rendered part of the radiograph
+ * @return Crop in pixels, the whole radiograph if no crop is set
+ */
+QRect TOpenGLRenderer::getCropWindow()
+{
+    return myCrop.isNull() ? QRect(QPoint(0, 0), mySize) : myCrop;
+}
+
+/**
+ * @brief Sets the perspective pyramid
+ * @param perspective Perspective pyramid
+ */
+void TOpenGLRenderer::setPerspective(const SSIMRenderer::Pyramid & perspective)
+{
+    myRenderer->setPerspective(perspective);
+}
+
+/**
+ * @brief Sets the rotation of the model
+ * @param rotation Rotation vector
+ */
+void TOpenGLRenderer::setRotation(const QVector3D & rotation)
+{
+    myRenderer->setRotation(rotation);
+}
+
+/**
+ * @brief Gets the rotation of the model
+ * @return Rotation vector
+ */
+QVector3D TOpenGLRenderer::getRotation()
+{
+    return myRenderer->getRotation();
+}
+
+/**
+ * @brief Sets the translation of the model
+ * @param translation Translation vector
+ */
+void TOpenGLRenderer::setTranslation(const QVector3D & translation)
+{
+    myRenderer->setTranslation(translation);
+}
+
+/**
+ * @brief Gets the translation of the model
+ * @return Translation vector
+ */
+QVector3D TOpenGLRenderer::getTranslation()
+{
+    return myRenderer->getTranslation();
+}
+
+/**
+ * @brief Gets the transformation matrix of the model
+ * @return Transformation matrix, its inversion maps the model to the scene
+ */
+QMatrix4x4 TOpenGLRenderer::getTransformationMatrix()
+{
+    return myRenderer->getTransformationMatrix();
+}
+
+/**
+ * @brief Enables mirroring of the model along the x axis
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enableXMirroring(bool enable)
+{
+    myRenderer->enableXMirroring(enable);
+}
+
+/**
+ * @brief Enables rendering of the density
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enableDensity(bool enable)
+{
+    myRenderer->enableDensity(enable);
+}
+
+/**
+ * @brief Enables rendering of the silhouettes
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enableSilhouettes(bool enable)
+{
+    myRenderer->enableSilhouettes(enable);
+}
+
+/**
+ * @brief Enables rendering of the polygonal model
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enablePolygonal(bool enable)
+{
+    myRenderer->enablePolygonal(enable);
+}
+
+/**
+ * @brief Enables rendering of the perspective pyramid
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enablePyramid(bool enable)
+{
+    myRenderer->enablePyramid(enable);
+}
+
+/**
+ * @brief Enables lighting of the polygonal model
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enablePolygonalLighting(bool enable)
+{
+    myRenderer->enablePolygonalLighting(enable);
+}
+
+/**
+ * @brief Sets the intensity of the rendered density
+ * @param intensity Intensity
+ */
+void TOpenGLRenderer::setIntensity(float intensity)
+{
+    myRenderer->setIntensity(intensity);
+}
+
+/**
+ * @brief Enables log messages of the renderer
+ * @param enable Boolean value
+ */
+void TOpenGLRenderer::enableLogMessages(bool enable)
+{
+    myRenderer->enableLogMessages(enable);
+}
+
+/**
+ * @brief Sets the polygonal or tetrahedral mesh
+ * @param mesh Pointer to the mesh
+ * @param colors Colors of the vertices
+ */
+void TOpenGLRenderer::setMesh(SSIMRenderer::Mesh * mesh, float * colors)
+{
+    myRenderer->setMesh(mesh, colors);
+    myRoot->myShapeVersion++;
+}
+
+/**
+ * @brief Sets the shape model
+ * @param shapeFile Shape model
+ */
+void TOpenGLRenderer::setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile)
+{
+    myRenderer->setVertices(shapeFile);
+    myRoot->myShapeVersion++;
+}
+
+/**
+ * @brief Sets the density model
+ * @param densityFile Density model
+ */
+void TOpenGLRenderer::setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile)
+{
+    myRenderer->setCoefficients(densityFile);
+}
+
+/**
+ * @brief Gets the number of the shape model parameters
+ * @return Number of parameters
+ */
+int TOpenGLRenderer::getShapeParamsCount()
+{
+    return myRenderer->getStatisticalData()->getNumberOfParameters();
+}
+
+/**
+ * @brief Gets a shape parameter
+ * @param i Index of the parameter
+ * @return Principal component score
+ */
+float TOpenGLRenderer::getShapeParam(int i)
+{
+    return myRenderer->getStatisticalData()->getPcsMatrix()[i];
+}
+
+/**
+ * @brief Gets the standard deviation of a shape parameter
+ * @param i Index of the parameter
+ * @return Standard deviation
+ */
+float TOpenGLRenderer::getShapeStd(int i)
+{
+    return myRenderer->getStatisticalData()->getStdMatrix()[i];
+}
+
+/**
+ * @brief Sets the shape parameters and recomputes the vertices
+ * @param scores Principal component scores, the remaining parameters are kept
+ *
+ * The vertices are recomputed by SSIMRenderer from all modes, only if
+ * any of the scores changes.
+ *
+ */
+void TOpenGLRenderer::setShapeParams(const QVector<float> & scores)
+{
+    SSIMRenderer::StatisticalData * data = myRenderer->getStatisticalData();
+    bool changed = false;
+    for(int i = 0; i < scores.size(); i++)
+    {
+        if(data->getPcsMatrix()[i] == scores.at(i))
+            continue;
+
+        data->updatePcsMatrix(i, scores.at(i));
+        changed = true;
+    }
+
+    if(changed)
+    {
+        myRenderer->updateVertices(data);
+        myRoot->myShapeVersion++;
+    }
+}
+
+/**
+ * @brief Gets the version of the shape
+ * @return Counter increased by every change of the mesh, the shape model or the shape parameters
+ */
+unsigned int TOpenGLRenderer::getShapeVersion()
+{
+    return myRoot->myShapeVersion;
+}
+
+/**
+ * @brief Exports the model to a STL file
+ * @param fileName File name
+ */
+void TOpenGLRenderer::exportSTL(const QString & fileName)
+{
+    myRenderer->exportSTL(fileName);
+}
+
+/**
+ * @brief Exports the model to a STL file
+ * @param fileName File name
+ * @param transform Exports the model in the scene coordinates if set
+ */
+void TOpenGLRenderer::exportSTL(const QString & fileName, bool transform)
+{
+    myRenderer->exportSTL(fileName, transform);
+}
+
+/**
+ * @brief Exports a part of the model to a STL file
+ * @param fileName File name
+ * @param transform Exports the model in the scene coordinates if set
+ * @param mask Mask of the exported vertices
+ * @param flags Export flags of the renderer
+ */
+void TOpenGLRenderer::exportSTL(const QString & fileName, bool transform, const QVector<bool> & mask, int flags)
+{
+    myRenderer->exportSTL(fileName, transform, mask, flags);
+}
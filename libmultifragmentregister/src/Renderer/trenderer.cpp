@@ -0,0 +1,277 @@
+/**
+ * @file        trenderer.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TRenderer class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "Renderer/trenderer.h"
+#include "Renderer/topenglrenderer.h"
+#include "Renderer/tsoftwarerenderer.h"
+
+#include <assert.h>
+#include <algorithm>
+
+/**
+ * @brief Creates a renderer of the given backend
+ * @param backend Rendering backend
+ * @param parent Renderer sharing its model, shape and pose, must be of the same backend
+ * @return Pointer to the new renderer
+ */
+TRenderer * TRenderer::create(Backend backend, TRenderer * parent)
+{
+    assert(parent == NULL || parent->getBackend() == backend);
+
+    if(backend == SoftwareBackend)
+        return new TSoftwareRenderer(static_cast<TSoftwareRenderer *>(parent));
+
+    return new TOpenGLRenderer(static_cast<TOpenGLRenderer *>(parent));
+}
+
+/**
+ * @brief Default constructor of TRenderer class
+ */
+TRenderer::TRenderer():
+    myReadback(NULL)
+{
+}
+
+/**
+ * @brief Default destructor of TRenderer class
+ */
+TRenderer::~TRenderer()
+{
+    delete[] myReadback;
+}
+
+/**
+ * @brief Gets the underlying OpenGL renderer
+ * @return Pointer to the OpenGL renderer, null pointer for the other backends
+ *
+ * The OpenGL and OpenCL metrics compute directly from the OpenGL buffers
+ * and require the OpenGL backend.
+ *
+ */
+SSIMRenderer::OffscreenRenderer * TRenderer::getOffscreenRenderer()
+{
+    return NULL;
+}
+
+/**
+ * @brief Renders the views under several poses of the model in one batch
+ * @param[in] rotations Rotation of each pose
+ * @param[in] translations Translation of each pose
+ * @param[in] views Renderers sharing the pose of this renderer, including it
+ * @param[in] rendered Function called with the pose and view index once the image is rendered
+ * @param[in] rendering Optional function called with the pose and view index before the image is rendered
+ *
+ * The renderer has to own the pose, i.e. be the parent of the other views.
+ * The images of all views are rendered for each pose before the next pose
+ * is set, the rendered image of the view can be read by the function. The
+ * original pose is restored at the end.
+ *
+ */
+void TRenderer::renderPoses(const QVector<QVector3D> & rotations,
+                            const QVector<QVector3D> & translations,
+                            const QVector<TRenderer *> & views,
+                            const std::function<void(int, int)> & rendered,
+                            const std::function<void(int, int)> & rendering)
+{
+    assert(rotations.size() == translations.size());
+
+    const QVector3D rotation    = getRotation();
+    const QVector3D translation = getTranslation();
+
+    for(int pose = 0; pose < rotations.size(); pose++)
+    {
+        setRotation(rotations.at(pose));
+        setTranslation(translations.at(pose));
+        for(int view = 0; view < views.size(); view++)
+        {
+            if(rendering)
+                rendering(pose, view);
+            views[view]->renderNow();
+            rendered(pose, view);
+        }
+    }
+
+    setRotation(rotation);
+    setTranslation(translation);
+}
+
+/**
+ * @brief Computes the masks of the visible vertices of several views at once
+ * @param[in] vertices Vertices in the model coordinates, x, y, z triplets
+ * @param[in] nv Number of vertices
+ * @param[in] views Renderers sharing the pose of this renderer, including it
+ * @param[in] crops Crop of each view in OpenGL coordinates
+ * @param[in] angles Angle of each view
+ * @param[out] masks Packed mask of each view, bit i % 64 of word i / 64 is set for the visible vertex i
+ *
+ * The default implementation packs the masks of getVerticesMask() of each view.
+ *
+ */
+void TRenderer::getVerticesMasks(const float * vertices, int nv,
+                                 const QVector<TRenderer *> & views,
+                                 const QVector<QRectF> & crops,
+                                 const QVector<double> & angles,
+                                 QVector<QVector<quint64> > & masks)
+{
+    assert(views.size() == crops.size() && views.size() == angles.size());
+
+    masks.resize(views.size());
+    for(int view = 0; view < views.size(); view++)
+        masks[view] = packMask(views[view]->getVerticesMask(vertices, nv, crops.at(view), angles.at(view)));
+}
+
+/**
+ * @brief Packs a mask into 64-bit words
+ * @param[in] mask Mask
+ * @return Packed mask, bit i % 64 of word i / 64 stands for the item i
+ */
+QVector<quint64> TRenderer::packMask(const QVector<bool> & mask)
+{
+    QVector<quint64> bits((mask.size() + 63) / 64, 0);
+    for(int i = 0; i < mask.size(); i++)
+        if(mask.at(i))
+            bits[i / 64] |= quint64(1) << (i % 64);
+
+    return bits;
+}
+
+/**
+ * @brief Unpacks a mask packed by packMask()
+ * @param[in] bits Packed mask
+ * @param[in] n Number of items
+ * @return Mask
+ */
+QVector<bool> TRenderer::unpackMask(const QVector<quint64> & bits, int n)
+{
+    QVector<bool> mask(n);
+    for(int i = 0; i < n; i++)
+        mask[i] = (bits.at(i / 64) >> (i % 64)) & 1;
+
+    return mask;
+}
+
+/**
+ * @brief Gets the region of the rendered image that may contain non-zero values
+ * @return Rectangle in the image coordinates, rows are counted bottom-up
+ *
+ * The default implementation returns the whole image.
+ *
+ */
+QRect TRenderer::getRenderedBounds()
+{
+    return QRect(QPoint(0, 0), getRenderedSize());
+}
+
+/**
+ * @brief Gets the rendered values of a region of the image
+ * @param[out] data Buffer of region.width() * region.height() values allocated by the caller
+ * @param[in] region Rectangle inside the image, rows are counted bottom-up
+ *
+ * The default implementation reads the whole red channel and copies the region.
+ *
+ */
+void TRenderer::getRenderedRegion(float * data, const QRect & region)
+{
+    const int w = getRenderedSize().width();
+
+    float * image = NULL;
+    getRenderedRedChannel(image);
+
+    for(int y = 0; y < region.height(); y++)
+    {
+        const float * row = image + (region.top() + y) * w + region.left();
+        std::copy(row, row + region.width(), data + y * region.width());
+    }
+
+    delete[] image;
+}
+
+/**
+ * @brief Gets the rendered values without copying them to a buffer of the caller
+ * @param[out] stride Number of values between the starts of two rows
+ * @return Pointer to the red channel owned by the renderer, rows are stored bottom-up
+ *
+ * The values stay valid until the next rendering, the next call or a change
+ * of the crop window. The default implementation keeps the last buffer
+ * read by getRenderedRedChannel(), so that the caller neither allocates
+ * nor frees it.
+ *
+ */
+const float * TRenderer::getRenderedRedChannelBuffer(int & stride)
+{
+    delete[] myReadback;
+    myReadback = NULL;
+    getRenderedRedChannel(myReadback);
+
+    stride = getRenderedSize().width();
+    return myReadback;
+}
+
+/**
+ * @brief Sets the threads shared by the renderers and metrics of the registration
+ * @param pool Worker pool, the renderer renders in the calling thread only if null
+ *
+ * The renderers rendering in the calling thread ignore the pool.
+ *
+ */
+void TRenderer::setWorkerPool(TWorkerPool * pool)
+{
+    Q_UNUSED(pool);
+}
+
+/**
+ * @brief Enables rendering of the packed mask only
+ * @param enable Boolean value
+ *
+ * The renderers not supporting the mode keep rendering the full image,
+ * the packed mask is then obtained by thresholding the red channel.
+ *
+ */
+void TRenderer::enableBitMask(bool enable)
+{
+    Q_UNUSED(enable);
+}
+
+/**
+ * @brief Gets the packed mask of the pixels covered by the model
+ * @param bits Packed mask, resized by the function
+ *
+ * The pixels with the red channel of at least 0.5 are covered.
+ *
+ */
+void TRenderer::getRenderedBits(QVector<quint64> & bits)
+{
+    const QSize size = getRenderedSize();
+    const int stride = getBitsStride(size.width());
+
+    float * data = NULL;
+    getRenderedRedChannel(data);
+
+    bits.fill(0, stride * size.height());
+    for(int y = 0; y < size.height(); y++)
+    {
+        const float * row = data + y * size.width();
+        quint64 * words = bits.data() + y * stride;
+        for(int x = 0; x < size.width(); x++)
+            if(row[x] >= 0.5f)
+                words[x / 64] |= quint64(1) << (x % 64);
+    }
+
+    delete[] data;
+}
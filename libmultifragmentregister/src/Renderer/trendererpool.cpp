@@ -0,0 +1,153 @@
+/**
+ * @file        trendererpool.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TRendererPool class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+
+#include "Renderer/trendererpool.h"
+
+#include <QMutexLocker>
+#include <assert.h>
+
+QMutex TRendererPool::myMutex;
+bool TRendererPool::myEnabled = false;
+QHash<TRenderer *, TRendererPool::TEntry> TRendererPool::myEntries;
+
+/**
+ * @brief Enables the reuse of the released renderers
+ * @param[in] enable Boolean value, the idle renderers of the current thread are deleted if not set
+ */
+void TRendererPool::setEnabled(bool enable)
+{
+    {
+        QMutexLocker locker(&myMutex);
+        myEnabled = enable;
+    }
+
+    if(!enable)
+        clear();
+}
+
+/**
+ * @brief Checks whether the released renderers are reused
+ * @return True if the pool is enabled
+ */
+bool TRendererPool::isEnabled()
+{
+    QMutexLocker locker(&myMutex);
+    return myEnabled;
+}
+
+/**
+ * @brief Leases a renderer
+ * @param[in] backend Rendering backend
+ * @param[in] parent Renderer sharing its model, shape and pose, must be of the same backend
+ * @return Idle renderer of the current thread with the same backend and parent, a new renderer if there is none
+ */
+TRenderer * TRendererPool::acquire(TRenderer::Backend backend, TRenderer * parent)
+{
+    QMutexLocker locker(&myMutex);
+    if(!myEnabled || (parent != NULL && !myEntries.contains(parent)))
+        return TRenderer::create(backend, parent);
+
+    QThread * thread = QThread::currentThread();
+    for(QHash<TRenderer *, TEntry>::iterator it = myEntries.begin(); it != myEntries.end(); ++it)
+    {
+        if(it.value().leased || it.value().thread != thread || it.value().parent != parent || it.key()->getBackend() != backend)
+            continue;
+
+        it.value().leased = true;
+        return it.key();
+    }
+
+    TRenderer * renderer = TRenderer::create(backend, parent);
+    TEntry entry;
+    entry.parent = parent;
+    entry.thread = thread;
+    entry.leased = true;
+    myEntries.insert(renderer, entry);
+
+    return renderer;
+}
+
+/**
+ * @brief Returns a leased renderer
+ * @param[in] renderer Renderer, the renderers created with it as the parent have to be returned first
+ *
+ * The renderer is reset and kept for the next lease, renderers leased
+ * while the pool was disabled are deleted.
+ *
+ */
+void TRendererPool::release(TRenderer * renderer)
+{
+    if(renderer == NULL)
+        return;
+
+    QMutexLocker locker(&myMutex);
+    if(!myEntries.contains(renderer))
+    {
+        locker.unlock();
+        delete renderer;
+        return;
+    }
+
+    assert(myEntries.value(renderer).leased);
+    renderer->reset();
+    myEntries[renderer].leased = false;
+}
+
+/**
+ * @brief Deletes the idle renderers of the current thread
+ *
+ * The renderers with a parent are deleted before their parents.
+ *
+ */
+void TRendererPool::clear()
+{
+    QMutexLocker locker(&myMutex);
+    QThread * thread = QThread::currentThread();
+
+    QList<TRenderer *> children;
+    QList<TRenderer *> roots;
+    for(QHash<TRenderer *, TEntry>::const_iterator it = myEntries.constBegin(); it != myEntries.constEnd(); ++it)
+    {
+        if(it.value().leased || it.value().thread != thread)
+            continue;
+
+        if(it.value().parent != NULL)
+            children << it.key();
+        else
+            roots << it.key();
+    }
+
+    foreach(TRenderer * renderer, children)
+    {
+        myEntries.remove(renderer);
+        delete renderer;
+    }
+
+    foreach(TRenderer * renderer, roots)
+    {
+        // Renderers still leased with this parent keep it alive
+        bool used = false;
+        foreach(const TEntry & entry, myEntries)
+            used = used || entry.parent == renderer;
+        if(used)
+            continue;
+
+        myEntries.remove(renderer);
+        delete renderer;
+    }
+}
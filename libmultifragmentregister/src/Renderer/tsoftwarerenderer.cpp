@@ -0,0 +1,1480 @@
+/**
+ * @file        tsoftwarerenderer.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TSoftwareRenderer class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "Renderer/tsoftwarerenderer.h"
+#include "Parallel/tworkerpool.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QTextStream>
+#include <QtMath>
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TSOFTWARERENDERER_SSE2
+#endif
+
+/**
+ * @brief Size of the rasterizer tiles in pixels
+ */
+static const int TileSize = 8;
+
+/**
+ * @brief Constructor of TSoftwareRenderer class
+ * @param[in] parent Renderer sharing its model, shape and pose
+ */
+TSoftwareRenderer::TSoftwareRenderer(TSoftwareRenderer * parent):
+    myRoot(parent != NULL ? parent->myRoot : this),
+    myModel(parent != NULL ? parent->myModel : new TModelData()),
+    myMirroring(false),
+    mySize(512, 512),
+    myDensity(false),
+    mySilhouettes(false),
+    myPolygonal(true),
+    myLighting(false),
+    myIntensity(1.0f),
+    myLogMessages(true),
+    myBitMask(false),
+    myBitsRendered(false),
+    myStride(0),
+    myBitsStride(0),
+    myWorkerPool(NULL)
+{
+}
+
+/**
+ * @brief Destructor of TSoftwareRenderer class
+ */
+TSoftwareRenderer::~TSoftwareRenderer()
+{
+    if(myRoot == this)
+        delete myModel;
+}
+
+/**
+ * @brief Gets the rendering backend
+ * @return Software backend
+ */
+TRenderer::Backend TSoftwareRenderer::getBackend() const
+{
+    return SoftwareBackend;
+}
+
+/**
+ * @brief Restores the settings of a new renderer
+ *
+ * The crop and all the rendering modes return to their defaults. The model,
+ * the shape, the size and the perspective are kept, the pose, the
+ * mirroring and the worker pool are shared and reset by the root renderer only.
+ *
+ */
+void TSoftwareRenderer::reset()
+{
+    if(myRoot == this)
+    {
+        myRotation = QVector3D();
+        myTranslation = QVector3D();
+        myMirroring = false;
+        myWorkerPool = NULL;
+    }
+
+    myCrop = QRect();
+    myDensity = false;
+    mySilhouettes = false;
+    myPolygonal = true;
+    myLighting = false;
+    myIntensity = 1.0f;
+    myLogMessages = true;
+    myBitMask = false;
+}
+
+/**
+ * @brief Renders the virtual radiograph into the buffer
+ */
+void TSoftwareRenderer::renderNow()
+{
+    renderScene(getSceneVertices());
+}
+
+/**
+ * @brief Renders the views under several poses of the model in one batch
+ * @param[in] rotations Rotation of each pose
+ * @param[in] translations Translation of each pose
+ * @param[in] views Software renderers sharing the model of this renderer
+ * @param[in] rendered Function called with the pose and view index once the image is rendered
+ * @param[in] rendering Optional function called with the pose and view index before the image is rendered
+ *
+ * The vertices are transformed to the scene once per pose and shared by
+ * all views, each view only projects and rasterizes them.
+ *
+ */
+void TSoftwareRenderer::renderPoses(const QVector<QVector3D> & rotations,
+                                    const QVector<QVector3D> & translations,
+                                    const QVector<TRenderer *> & views,
+                                    const std::function<void(int, int)> & rendered,
+                                    const std::function<void(int, int)> & rendering)
+{
+    assert(rotations.size() == translations.size());
+
+    const QVector3D rotation    = myRoot->myRotation;
+    const QVector3D translation = myRoot->myTranslation;
+
+    for(int pose = 0; pose < rotations.size(); pose++)
+    {
+        myRoot->myRotation    = rotations.at(pose);
+        myRoot->myTranslation = translations.at(pose);
+
+        const QVector<QVector3D> scene = getSceneVertices();
+        for(int view = 0; view < views.size(); view++)
+        {
+            assert(views.at(view)->getBackend() == SoftwareBackend);
+            TSoftwareRenderer * renderer = static_cast<TSoftwareRenderer *>(views.at(view));
+            assert(renderer->myRoot == myRoot);
+
+            if(rendering)
+                rendering(pose, view);
+            renderer->renderScene(scene);
+            rendered(pose, view);
+        }
+    }
+
+    myRoot->myRotation    = rotation;
+    myRoot->myTranslation = translation;
+}
+
+/**
+ * @brief Renders the scene vertices into the buffer
+ * @param[in] scene Vertices of the current shape in the scene coordinates
+ */
+void TSoftwareRenderer::renderScene(const QVector<QVector3D> & scene)
+{
+    myBitsRendered = myBitMask && !myDensity;
+    resizeBuffer();
+
+    if(scene.isEmpty())
+        return;
+
+    const QVector<QPointF> points = projectToBuffer(scene);
+    myBounds = getBounds(points);
+    if(myBounds.isEmpty())
+        return;
+
+    if(myDensity && !myModel->getDensities().isEmpty())
+        renderDensity(scene, points);
+    else if(myPolygonal || myDensity)
+    {
+        foreach(const QVector<unsigned int> & triangle, myModel->getTriangles())
+            rasterizeTriangle(points.at(triangle.at(0)), points.at(triangle.at(1)), points.at(triangle.at(2)), 1.0f);
+    }
+
+    if(mySilhouettes)
+        renderSilhouettes(scene, points);
+}
+
+/**
+ * @brief Gets the rendered image values
+ * @param[out] data Pointer to the buffer allocated by the function, rows are stored bottom-up
+ */
+void TSoftwareRenderer::getRenderedRedChannel(float *& data)
+{
+    const QRect crop = getCropRect();
+    const int w = crop.width();
+    const int h = crop.height();
+
+    data = new float[w * h];
+    if(myBitsRendered)
+    {
+        for(int y = 0; y < h; y++)
+        {
+            const quint64 * words = myBits.constData() + y * myBitsStride;
+            for(int x = 0; x < w; x++)
+                data[y * w + x] = (words[x / 64] >> (x % 64)) & 1 ? 1.0f : 0.0f;
+        }
+        return;
+    }
+
+    if(myBuffer.isEmpty())
+    {
+        std::fill(data, data + w * h, 0.0f);
+        return;
+    }
+
+    for(int y = 0; y < h; y++)
+        std::copy(myBuffer.constData() + y * myStride, myBuffer.constData() + y * myStride + w, data + y * w);
+}
+
+/**
+ * @brief Gets the region of the rendered image that may contain non-zero values
+ * @return Bounds of the projected vertices padded to whole tiles and clipped by the image
+ */
+QRect TSoftwareRenderer::getRenderedBounds()
+{
+    return myBounds.intersected(QRect(QPoint(0, 0), getCropRect().size()));
+}
+
+/**
+ * @brief Gets the rendered values of a region of the image
+ * @param[out] data Buffer of region.width() * region.height() values allocated by the caller
+ * @param[in] region Rectangle inside the image, rows are counted bottom-up
+ */
+void TSoftwareRenderer::getRenderedRegion(float * data, const QRect & region)
+{
+    const int w = region.width();
+    for(int y = 0; y < region.height(); y++)
+    {
+        float * row = data + y * w;
+        const int by = region.top() + y;
+        if(myBitsRendered)
+        {
+            const quint64 * words = myBits.constData() + by * myBitsStride;
+            for(int x = 0; x < w; x++)
+            {
+                const int bx = region.left() + x;
+                row[x] = (words[bx / 64] >> (bx % 64)) & 1 ? 1.0f : 0.0f;
+            }
+        }
+        else if(myBuffer.isEmpty())
+            std::fill(row, row + w, 0.0f);
+        else
+        {
+            const float * line = myBuffer.constData() + by * myStride + region.left();
+            std::copy(line, line + w, row);
+        }
+    }
+}
+
+/**
+ * @brief Gets the rendered values without copying them to a buffer of the caller
+ * @param[out] stride Number of values between the starts of two rows
+ * @return Pointer to the rendering buffer, rows are stored bottom-up
+ *
+ * The rendering buffer itself is returned, only the packed mask is converted
+ * to a separate buffer, see TRenderer::getRenderedRedChannelBuffer().
+ *
+ */
+const float * TSoftwareRenderer::getRenderedRedChannelBuffer(int & stride)
+{
+    if(myBitsRendered || myBuffer.isEmpty())
+        return TRenderer::getRenderedRedChannelBuffer(stride);
+
+    stride = myStride;
+    return myBuffer.constData();
+}
+
+/**
+ * @brief Gets the size of the rendered image
+ * @return Size of the crop window, size of the whole radiograph if no crop is set
+ */
+QSize TSoftwareRenderer::getRenderedSize()
+{
+    return getCropRect().size();
+}
+
+/**
+ * @brief Enables rendering of the packed mask only
+ * @param[in] enable Boolean value
+ *
+ * The triangles are rasterized directly into the packed mask, the density
+ * is always rendered into the full buffer.
+ *
+ */
+void TSoftwareRenderer::enableBitMask(bool enable)
+{
+    myBitMask = enable;
+}
+
+/**
+ * @brief Gets the packed mask of the pixels covered by the model
+ * @param[out] bits Packed mask, resized by the function
+ */
+void TSoftwareRenderer::getRenderedBits(QVector<quint64> & bits)
+{
+    if(!myBitsRendered)
+    {
+        TRenderer::getRenderedBits(bits);
+        return;
+    }
+
+    const QRect crop = getCropRect();
+    const int stride = getBitsStride(crop.width());
+    const quint64 last = crop.width() % 64 == 0 ? ~quint64(0) : (quint64(1) << (crop.width() % 64)) - 1;
+
+    bits.resize(stride * crop.height());
+    for(int y = 0; y < crop.height(); y++)
+    {
+        std::copy(myBits.constData() + y * myBitsStride, myBits.constData() + y * myBitsStride + stride, bits.data() + y * stride);
+        bits[y * stride + stride - 1] &= last;
+    }
+}
+
+/**
+ * @brief Gets the rendered image
+ * @return Grayscale image, rows are stored top-down
+ */
+QImage TSoftwareRenderer::getRenderedImage()
+{
+    const QRect crop = getCropRect();
+    const int w = crop.width();
+    const int h = crop.height();
+
+    float * data = NULL;
+    getRenderedRedChannel(data);
+
+    QImage image(w, h, QImage::Format_RGB32);
+    for(int y = 0; y < h; y++)
+    {
+        const float * row = data + (h - 1 - y) * w;
+        QRgb * line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for(int x = 0; x < w; x++)
+        {
+            const int g = qBound(0, qRound(row[x] * 255.0f), 255);
+            line[x] = qRgb(g, g, g);
+        }
+    }
+
+    delete[] data;
+    return image;
+}
+
+/**
+ * @brief Gets the mask of the vertices projected inside the whole radiograph
+ * @param[in] vertices Buffer of vertices in the model coordinates
+ * @param[in] nv Number of vertices
+ * @return Vertices mask
+ */
+QVector<bool> TSoftwareRenderer::getVerticesMask(const float * vertices, int nv)
+{
+    return getVerticesMask(vertices, nv, QRectF(), 0.0, false);
+}
+
+/**
+ * @brief Gets the mask of the vertices projected inside a crop of the radiograph
+ * @param[in] vertices Buffer of vertices in the model coordinates
+ * @param[in] nv Number of vertices
+ * @param[in] crop Crop in the normalized device coordinates of the whole radiograph, null crop means the whole radiograph
+ * @param[in] angle Angle of the crop in degrees
+ * @return Vertices mask
+ */
+QVector<bool> TSoftwareRenderer::getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle)
+{
+    return getVerticesMask(vertices, nv, crop, angle, !crop.isNull());
+}
+
+/**
+ * @brief Gets the mask of the vertices projected inside a crop of the radiograph
+ * @param[in] vertices Buffer of vertices in the model coordinates
+ * @param[in] nv Number of vertices
+ * @param[in] crop Crop in the normalized device coordinates
+ * @param[in] angle Angle of the crop in degrees
+ * @param[in] cropped Whole radiograph is tested if not set
+ * @return Vertices mask
+ */
+QVector<bool> TSoftwareRenderer::getVerticesMask(const float * vertices, int nv, const QRectF & crop, double angle, bool cropped)
+{
+    assert(vertices != NULL);
+
+    const QMatrix4x4 model = getModelMatrix();
+    const QRectF rect = crop.normalized();
+    const double c = cos(qDegreesToRadians(angle));
+    const double s = sin(qDegreesToRadians(angle));
+
+    QVector<bool> mask(nv);
+    for(int i = 0; i < nv; i++)
+    {
+        const QVector3D p = model * QVector3D(vertices[i * 3 + 0], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+        const QPointF uv = myProjection.project(p);
+        const double x = 2.0 * uv.x() / mySize.width() - 1.0;
+        const double y = 1.0 - 2.0 * uv.y() / mySize.height();
+
+        if(cropped)
+            mask[i] = rect.contains(QPointF(c * x + s * y, c * y - s * x));
+        else
+            mask[i] = qAbs(x) <= 1.0 && qAbs(y) <= 1.0;
+    }
+
+    return mask;
+}
+
+/**
+ * @brief Computes the masks of the visible vertices of several views at once
+ * @param[in] vertices Vertices in the model coordinates, x, y, z triplets
+ * @param[in] nv Number of vertices
+ * @param[in] views Software renderers sharing the pose of this renderer, including it
+ * @param[in] crops Crop of each view in OpenGL coordinates
+ * @param[in] angles Angle of each view
+ * @param[out] masks Packed mask of each view, bit i % 64 of word i / 64 is set for the visible vertex i
+ *
+ * The vertices are transposed to a structure of arrays once for all views.
+ * The model matrix, the projection of the view, the normalized device
+ * coordinates and the rotation by the angle are combined into one matrix
+ * per view, four vertices are then tested at a time by SSE instructions.
+ *
+ */
+void TSoftwareRenderer::getVerticesMasks(const float * vertices, int nv,
+                                         const QVector<TRenderer *> & views,
+                                         const QVector<QRectF> & crops,
+                                         const QVector<double> & angles,
+                                         QVector<QVector<quint64> > & masks)
+{
+    assert(vertices != NULL);
+    assert(views.size() == crops.size() && views.size() == angles.size());
+
+    const int words = (nv + 63) / 64;
+    QVector<float> x(words * 64, 0.0f);
+    QVector<float> y(words * 64, 0.0f);
+    QVector<float> z(words * 64, 0.0f);
+    for(int i = 0; i < nv; i++)
+    {
+        x[i] = vertices[i * 3 + 0];
+        y[i] = vertices[i * 3 + 1];
+        z[i] = vertices[i * 3 + 2];
+    }
+
+    const QMatrix4x4 model = getModelMatrix();
+    masks.resize(views.size());
+    for(int view = 0; view < views.size(); view++)
+    {
+        assert(views.at(view)->getBackend() == SoftwareBackend);
+        const TSoftwareRenderer * renderer = static_cast<const TSoftwareRenderer *>(views.at(view));
+        assert(renderer->myRoot == myRoot);
+
+        // Whole radiograph is tested if no crop is given, see getVerticesMask()
+        const bool cropped = !crops.at(view).isNull();
+        const QRectF rect = cropped ? crops.at(view).normalized() : QRectF(-1.0, -1.0, 2.0, 2.0);
+        const float c = cropped ? cos(qDegreesToRadians(angles.at(view))) : 1.0f;
+        const float s = cropped ? sin(qDegreesToRadians(angles.at(view))) : 0.0f;
+
+        // Pixel coordinates to the normalized device coordinates (2u / width - 1, 1 - 2v / height)
+        const QMatrix4x4 ndc(2.0f / renderer->mySize.width(), 0.0f, 0.0f, -1.0f,
+                             0.0f, -2.0f / renderer->mySize.height(), 0.0f, 1.0f,
+                             0.0f, 0.0f, 1.0f, 0.0f,
+                             0.0f, 0.0f, 0.0f, 1.0f);
+        // Rotation of the crop, (c * x + s * y, c * y - s * x)
+        const QMatrix4x4 rotation(   c,    s, 0.0f, 0.0f,
+                                    -s,    c, 0.0f, 0.0f,
+                                  0.0f, 0.0f, 1.0f, 0.0f,
+                                  0.0f, 0.0f, 0.0f, 1.0f);
+
+        masks[view].fill(0, words);
+        maskVertices(rotation * ndc * renderer->myProjection.getMatrix() * model, rect,
+                     x.constData(), y.constData(), z.constData(), words * 64, masks[view].data());
+        if(nv % 64 != 0)
+            masks[view][words - 1] &= (quint64(1) << (nv % 64)) - 1;
+    }
+}
+
+/**
+ * @brief Tests whether the projected vertices are inside a rectangle
+ * @param[in] m Matrix mapping the model to the homogeneous coordinates of the rectangle
+ * @param[in] rect Rectangle, the edges are inside
+ * @param[in] x X coordinates of the vertices
+ * @param[in] y Y coordinates of the vertices
+ * @param[in] z Z coordinates of the vertices
+ * @param[in] n Number of vertices, a multiple of 64
+ * @param[out] bits Packed mask, the bits of the vertices inside are set
+ */
+void TSoftwareRenderer::maskVertices(const QMatrix4x4 & m, const QRectF & rect, const float * x, const float * y, const float * z, int n, quint64 * bits) const
+{
+    const float left   = rect.left();
+    const float right  = rect.right();
+    const float top    = rect.top();
+    const float bottom = rect.bottom();
+
+#ifdef TSOFTWARERENDERER_SSE2
+    __m128 r[3][4];
+    for(int row = 0; row < 3; row++)
+        for(int col = 0; col < 4; col++)
+            r[row][col] = _mm_set1_ps(m(row == 2 ? 3 : row, col));
+
+    const __m128 l = _mm_set1_ps(left);
+    const __m128 rt = _mm_set1_ps(right);
+    const __m128 t = _mm_set1_ps(top);
+    const __m128 b = _mm_set1_ps(bottom);
+
+    for(int i = 0; i < n; i += 4)
+    {
+        const __m128 px = _mm_loadu_ps(x + i);
+        const __m128 py = _mm_loadu_ps(y + i);
+        const __m128 pz = _mm_loadu_ps(z + i);
+
+        __m128 h[3];
+        for(int row = 0; row < 3; row++)
+            h[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[row][0], px), _mm_mul_ps(r[row][1], py)),
+                                _mm_add_ps(_mm_mul_ps(r[row][2], pz), r[row][3]));
+
+        const __m128 u = _mm_div_ps(h[0], h[2]);
+        const __m128 v = _mm_div_ps(h[1], h[2]);
+        const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(u, l), _mm_cmple_ps(u, rt)),
+                                         _mm_and_ps(_mm_cmpge_ps(v, t), _mm_cmple_ps(v, b)));
+
+        bits[i / 64] |= quint64(_mm_movemask_ps(inside)) << (i % 64);
+    }
+#else
+    for(int i = 0; i < n; i++)
+    {
+        const float w = m(3, 0) * x[i] + m(3, 1) * y[i] + m(3, 2) * z[i] + m(3, 3);
+        const float u = (m(0, 0) * x[i] + m(0, 1) * y[i] + m(0, 2) * z[i] + m(0, 3)) / w;
+        const float v = (m(1, 0) * x[i] + m(1, 1) * y[i] + m(1, 2) * z[i] + m(1, 3)) / w;
+        if(u >= left && u <= right && v >= top && v <= bottom)
+            bits[i / 64] |= quint64(1) << (i % 64);
+    }
+#endif
+}
+
+/**
+ * @brief Gets the vertices of the current shape
+ * @param[out] vertices Pointer to the buffer allocated by the function
+ * @param[in] transformed Vertices are in the scene coordinates if set
+ * @return Number of vertices
+ */
+int TSoftwareRenderer::getRecomputedVertices(float *& vertices, bool transformed)
+{
+    const QVector<QVector3D> v = getRecomputedVertices(transformed);
+    vertices = new float[v.size() * 3];
+    for(int i = 0; i < v.size(); i++)
+    {
+        vertices[i * 3 + 0] = v.at(i).x();
+        vertices[i * 3 + 1] = v.at(i).y();
+        vertices[i * 3 + 2] = v.at(i).z();
+    }
+
+    return v.size();
+}
+
+/**
+ * @brief Gets the vertices of the current shape
+ * @param[in] transformed Vertices are in the scene coordinates if set
+ * @return Vector of vertices
+ */
+QVector<QVector3D> TSoftwareRenderer::getRecomputedVertices(bool transformed)
+{
+    return transformed ? getSceneVertices() : myModel->getVertices();
+}
+
+/**
+ * @brief Gets the number of vertices of the mesh
+ * @return Number of vertices
+ */
+int TSoftwareRenderer::getNumberOfVertices()
+{
+    return myModel->getNumberOfVertices();
+}
+
+/**
+ * @brief Gets the triangles of the mesh
+ * @return Vector of triangles, three vertex indices each
+ */
+QVector<QVector<unsigned int> > TSoftwareRenderer::getTriangles()
+{
+    return myModel->getTriangles();
+}
+
+/**
+ * @brief Sets the size of the whole radiograph
+ * @param[in] width Width in pixels
+ * @param[in] height Height in pixels
+ */
+void TSoftwareRenderer::setRenderSize(int width, int height)
+{
+    mySize = QSize(width, height);
+}
+
+/**
+ * @brief Sets the rendered part of the radiograph
+ * @param[in] crop Crop in pixels, null crop renders the whole radiograph
+ */
+void TSoftwareRenderer::setCropWindow(const QRect & crop)
+{
+    myCrop = crop;
+}
+
+/**
+ * @brief Gets the rendered part of the radiograph
+ * @return Crop in pixels, the whole radiograph if no crop is set
+ */
+QRect TSoftwareRenderer::getCropWindow()
+{
+    return getCropRect();
+}
+
+/**
+ * @brief Sets the perspective pyramid
+ * @param[in] perspective Perspective pyramid
+ *
+ * The render size has to be set before the perspective.
+ *
+ */
+void TSoftwareRenderer::setPerspective(const SSIMRenderer::Pyramid & perspective)
+{
+    myProjection = TProjection(perspective, mySize);
+}
+
+/**
+ * @brief Sets the rotation of the model
+ * @param[in] rotation Angles around the x, y and z axes in degrees
+ */
+void TSoftwareRenderer::setRotation(const QVector3D & rotation)
+{
+    myRoot->myRotation = rotation;
+}
+
+/**
+ * @brief Gets the rotation of the model
+ * @return Rotation vector
+ */
+QVector3D TSoftwareRenderer::getRotation()
+{
+    return myRoot->myRotation;
+}
+
+/**
+ * @brief Sets the translation of the model
+ * @param[in] translation Translation vector
+ */
+void TSoftwareRenderer::setTranslation(const QVector3D & translation)
+{
+    myRoot->myTranslation = translation;
+}
+
+/**
+ * @brief Gets the translation of the model
+ * @return Translation vector
+ */
+QVector3D TSoftwareRenderer::getTranslation()
+{
+    return myRoot->myTranslation;
+}
+
+/**
+ * @brief Gets the transformation matrix of the model
+ * @return Transformation matrix, its inversion maps the model to the scene
+ */
+QMatrix4x4 TSoftwareRenderer::getTransformationMatrix()
+{
+    return getModelMatrix().inverted();
+}
+
+/**
+ * @brief Enables mirroring of the model along the x axis
+ * @param[in] enable Boolean value
+ */
+void TSoftwareRenderer::enableXMirroring(bool enable)
+{
+    myRoot->myMirroring = enable;
+}
+
+/**
+ * @brief Enables rendering of the density
+ * @param[in] enable Boolean value
+ *
+ * The covered area of the model is rendered instead if the mesh has no
+ * tetrahedra or no density model is set.
+ *
+ */
+void TSoftwareRenderer::enableDensity(bool enable)
+{
+    myDensity = enable;
+}
+
+/**
+ * @brief Enables rendering of the silhouettes
+ * @param[in] enable Boolean value
+ */
+void TSoftwareRenderer::enableSilhouettes(bool enable)
+{
+    mySilhouettes = enable;
+}
+
+/**
+ * @brief Enables rendering of the polygonal model
+ * @param[in] enable Boolean value
+ */
+void TSoftwareRenderer::enablePolygonal(bool enable)
+{
+    myPolygonal = enable;
+}
+
+/**
+ * @brief Enables rendering of the perspective pyramid, not supported
+ * @param[in] enable Boolean value
+ */
+void TSoftwareRenderer::enablePyramid(bool enable)
+{
+    if(enable && myLogMessages)
+        qDebug() << "WARNING: TSoftwareRenderer does not render the perspective pyramid.";
+}
+
+/**
+ * @brief Enables lighting of the polygonal model, not supported
+ * @param[in] enable Boolean value
+ */
+void TSoftwareRenderer::enablePolygonalLighting(bool enable)
+{
+    myLighting = enable;
+    if(enable && myLogMessages)
+        qDebug() << "WARNING: TSoftwareRenderer renders the polygonal model without lighting.";
+}
+
+/**
+ * @brief Sets the intensity of the rendered density
+ * @param[in] intensity Attenuation per unit of the density integral
+ */
+void TSoftwareRenderer::setIntensity(float intensity)
+{
+    myIntensity = intensity;
+}
+
+/**
+ * @brief Enables log messages of the renderer
+ * @param[in] enable Boolean value
+ */
+void TSoftwareRenderer::enableLogMessages(bool enable)
+{
+    myLogMessages = enable;
+}
+
+/**
+ * @brief Sets the polygonal or tetrahedral mesh
+ * @param[in] mesh Pointer to the mesh
+ * @param[in] colors Colors of the vertices, the model is always rendered in white
+ */
+void TSoftwareRenderer::setMesh(SSIMRenderer::Mesh * mesh, float * colors)
+{
+    Q_UNUSED(colors);
+    myModel->setMesh(mesh);
+}
+
+/**
+ * @brief Sets the shape model
+ * @param[in] shapeFile Shape model
+ */
+void TSoftwareRenderer::setShapeModel(SSIMRenderer::MatStatisticalDataFile * shapeFile)
+{
+    myModel->setShapeModel(shapeFile);
+}
+
+/**
+ * @brief Sets the density model
+ * @param[in] densityFile Density model
+ */
+void TSoftwareRenderer::setDensityModel(SSIMRenderer::MatStatisticalDataFile * densityFile)
+{
+    myModel->setDensityModel(densityFile);
+}
+
+/**
+ * @brief Gets the number of the shape model parameters
+ * @return Number of parameters
+ */
+int TSoftwareRenderer::getShapeParamsCount()
+{
+    return myModel->getShapeParamsCount();
+}
+
+/**
+ * @brief Gets a shape parameter
+ * @param[in] i Index of the parameter
+ * @return Principal component score
+ */
+float TSoftwareRenderer::getShapeParam(int i)
+{
+    return myModel->getShapeParam(i);
+}
+
+/**
+ * @brief Gets the standard deviation of a shape parameter
+ * @param[in] i Index of the parameter
+ * @return Standard deviation
+ */
+float TSoftwareRenderer::getShapeStd(int i)
+{
+    return myModel->getShapeStd(i);
+}
+
+/**
+ * @brief Sets the shape parameters and recomputes the vertices
+ * @param[in] scores Principal component scores, the remaining parameters are kept
+ */
+void TSoftwareRenderer::setShapeParams(const QVector<float> & scores)
+{
+    myModel->setShapeParams(scores);
+}
+
+/**
+ * @brief Gets the version of the shape
+ * @return Counter increased by every change of the vertices of the model
+ */
+unsigned int TSoftwareRenderer::getShapeVersion()
+{
+    return myModel->getVersion();
+}
+
+/**
+ * @brief Exports the model in the scene coordinates to an ASCII STL file
+ * @param[in] fileName File name
+ */
+void TSoftwareRenderer::exportSTL(const QString & fileName)
+{
+    exportSTL(fileName, true, QVector<bool>());
+}
+
+/**
+ * @brief Exports the model to an ASCII STL file
+ * @param[in] fileName File name
+ * @param[in] transform Exports the model in the scene coordinates if set
+ */
+void TSoftwareRenderer::exportSTL(const QString & fileName, bool transform)
+{
+    exportSTL(fileName, transform, QVector<bool>());
+}
+
+/**
+ * @brief Exports a part of the model to an ASCII STL file
+ * @param[in] fileName File name
+ * @param[in] transform Exports the model in the scene coordinates if set
+ * @param[in] mask Mask of the exported vertices, triangles with all vertices masked are exported
+ * @param[in] flags Export flags of the OpenGL renderer, ignored
+ */
+void TSoftwareRenderer::exportSTL(const QString & fileName, bool transform, const QVector<bool> & mask, int flags)
+{
+    Q_UNUSED(flags);
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "ERROR: Cannot open" << fileName;
+        return;
+    }
+
+    const QVector<QVector3D> vertices = getRecomputedVertices(transform);
+
+    QTextStream out(&file);
+    out << "solid model\n";
+    foreach(const QVector<unsigned int> & triangle, myModel->getTriangles())
+    {
+        if(!mask.isEmpty() && !(mask.at(triangle.at(0)) && mask.at(triangle.at(1)) && mask.at(triangle.at(2))))
+            continue;
+
+        const QVector3D & a = vertices.at(triangle.at(0));
+        const QVector3D & b = vertices.at(triangle.at(1));
+        const QVector3D & c = vertices.at(triangle.at(2));
+        const QVector3D n = QVector3D::normal(a, b, c);
+
+        out << "facet normal " << n.x() << " " << n.y() << " " << n.z() << "\n";
+        out << "outer loop\n";
+        out << "vertex " << a.x() << " " << a.y() << " " << a.z() << "\n";
+        out << "vertex " << b.x() << " " << b.y() << " " << b.z() << "\n";
+        out << "vertex " << c.x() << " " << c.y() << " " << c.z() << "\n";
+        out << "endloop\n";
+        out << "endfacet\n";
+    }
+    out << "endsolid model\n";
+}
+
+/**
+ * @brief Sets the threads rendering the density
+ * @param[in] pool Worker pool, the renderers sharing the parent use its pool
+ *
+ * The density is rendered in the calling thread if the pool is null.
+ *
+ */
+void TSoftwareRenderer::setWorkerPool(TWorkerPool * pool)
+{
+    myRoot->myWorkerPool = pool;
+}
+
+/**
+ * @brief Gets the matrix mapping the model to the scene
+ * @return Model matrix
+ *
+ * The matrix is composed as the model matrix of SSIMRenderer, i.e. the
+ * translation, the rotations about the x, y and z axes in degrees and the
+ * mirroring, the model is therefore rotated about the z axis first.
+ *
+ */
+QMatrix4x4 TSoftwareRenderer::getModelMatrix() const
+{
+    QMatrix4x4 m;
+    m.translate(myRoot->myTranslation);
+    m.rotate(myRoot->myRotation.x(), 1.0f, 0.0f, 0.0f);
+    m.rotate(myRoot->myRotation.y(), 0.0f, 1.0f, 0.0f);
+    m.rotate(myRoot->myRotation.z(), 0.0f, 0.0f, 1.0f);
+    if(myRoot->myMirroring)
+        m.scale(-1.0f, 1.0f, 1.0f);
+
+    return m;
+}
+
+/**
+ * @brief Gets the vertices of the current shape in the scene coordinates
+ * @return Vector of vertices
+ */
+QVector<QVector3D> TSoftwareRenderer::getSceneVertices() const
+{
+    const QMatrix4x4 m = getModelMatrix();
+    QVector<QVector3D> vertices = myModel->getVertices();
+    for(int i = 0; i < vertices.size(); i++)
+        vertices[i] = m * vertices.at(i);
+
+    return vertices;
+}
+
+/**
+ * @brief Gets the rendered part of the radiograph
+ * @return Crop in pixels
+ */
+QRect TSoftwareRenderer::getCropRect() const
+{
+    return myCrop.isNull() ? QRect(QPoint(0, 0), mySize) : myCrop;
+}
+
+/**
+ * @brief Projects the scene vertices to the buffer
+ * @param[in] vertices Vertices in the scene coordinates
+ * @return Continuous buffer coordinates, the origin is in the left bottom corner of the crop
+ */
+QVector<QPointF> TSoftwareRenderer::projectToBuffer(const QVector<QVector3D> & vertices) const
+{
+    const QRect crop = getCropRect();
+    QVector<QPointF> points(vertices.size());
+    for(int i = 0; i < vertices.size(); i++)
+    {
+        const QPointF p = myProjection.project(vertices.at(i));
+        points[i] = QPointF(p.x() - crop.left(), crop.top() + crop.height() - p.y());
+    }
+
+    return points;
+}
+
+/**
+ * @brief Resizes and clears the buffer or the packed mask, both are padded to whole tiles
+ *
+ * The width padded to whole tiles never exceeds the whole words of the
+ * packed mask as the words are multiples of the tile size. Unless the size
+ * changes, only the bounds of the previous rendering are cleared, the
+ * target which is not rendered into is released.
+ *
+ */
+void TSoftwareRenderer::resizeBuffer()
+{
+    const QRect crop = getCropRect();
+    const int stride = (crop.width() + TileSize - 1) / TileSize * TileSize;
+    const int bitsStride = getBitsStride(crop.width());
+    const int rows = (crop.height() + TileSize - 1) / TileSize * TileSize;
+
+    if(myBitsRendered)
+    {
+        myBuffer.clear();
+        if(bitsStride != myBitsStride || myBits.size() != bitsStride * rows)
+        {
+            myBits.resize(bitsStride * rows);
+            myBits.fill(0);
+        }
+        else if(!myBounds.isEmpty())
+        {
+            for(int y = myBounds.top(); y <= myBounds.bottom(); y++)
+            {
+                quint64 * words = myBits.data() + y * bitsStride;
+                std::fill(words + myBounds.left() / 64, words + myBounds.right() / 64 + 1, 0);
+            }
+        }
+    }
+    else
+    {
+        myBits.clear();
+        if(stride != myStride || myBuffer.size() != stride * rows)
+        {
+            myBuffer.resize(stride * rows);
+            myBuffer.fill(0.0f);
+        }
+        else if(!myBounds.isEmpty())
+        {
+            for(int y = myBounds.top(); y <= myBounds.bottom(); y++)
+            {
+                float * line = myBuffer.data() + y * stride;
+                std::fill(line + myBounds.left(), line + myBounds.right() + 1, 0.0f);
+            }
+        }
+    }
+
+    myStride = stride;
+    myBitsStride = bitsStride;
+    myBounds = QRect();
+}
+
+/**
+ * @brief Gets the bounds of the projected vertices in the buffer
+ * @param[in] points Vertices in the buffer coordinates
+ * @return Rectangle padded to whole tiles and clipped by the buffer, empty if the vertices are outside
+ *
+ * Every pixel the rasterizer writes, including whole accepted tiles and
+ * the four-pixel packets of the density integration, lies inside the bounds.
+ *
+ */
+QRect TSoftwareRenderer::getBounds(const QVector<QPointF> & points) const
+{
+    const int rows = myBitsRendered ? myBits.size() / qMax(1, myBitsStride) : myBuffer.size() / qMax(1, myStride);
+
+    double minX =  1e30, minY =  1e30;
+    double maxX = -1e30, maxY = -1e30;
+    foreach(const QPointF & p, points)
+    {
+        // NaN coordinates fail all comparisons
+        if(!(p.x() == p.x() && p.y() == p.y()))
+            continue;
+        minX = qMin(minX, p.x());
+        maxX = qMax(maxX, p.x());
+        minY = qMin(minY, p.y());
+        maxY = qMax(maxY, p.y());
+    }
+
+    if(maxX < 0.0 || maxY < 0.0 || minX >= myStride || minY >= rows)
+        return QRect();
+
+    const int left   = int(floor(qMax(minX, 0.0))) / TileSize * TileSize;
+    const int top    = int(floor(qMax(minY, 0.0))) / TileSize * TileSize;
+    const int right  = qMin(myStride - 1, int(floor(qMin(maxX, double(myStride)))) / TileSize * TileSize + TileSize - 1);
+    const int bottom = qMin(rows - 1,     int(floor(qMin(maxY, double(rows))))     / TileSize * TileSize + TileSize - 1);
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+/**
+ * @brief Rasterizes a triangle into the buffer
+ * @param[in] a First vertex in the buffer coordinates
+ * @param[in] b Second vertex in the buffer coordinates
+ * @param[in] c Third vertex in the buffer coordinates
+ * @param[in] value Value of the covered pixels
+ *
+ * The pixel is covered if its center is inside the triangle, i.e. if all
+ * three edge functions A * x + B * y + C are non-negative.
+ *
+ */
+void TSoftwareRenderer::rasterizeTriangle(const QPointF & a, const QPointF & b, const QPointF & c, float value)
+{
+    const QRect crop = getCropRect();
+    const double area = (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+    if(area == 0.0 || area != area)
+        return;
+
+    const QPointF p[3] = {a, area > 0.0 ? b : c, area > 0.0 ? c : b};
+
+    const int minX = qMax(0, int(floor(qMin(p[0].x(), qMin(p[1].x(), p[2].x())))));
+    const int minY = qMax(0, int(floor(qMin(p[0].y(), qMin(p[1].y(), p[2].y())))));
+    const int maxX = qMin(crop.width()  - 1, int(floor(qMax(p[0].x(), qMax(p[1].x(), p[2].x())))));
+    const int maxY = qMin(crop.height() - 1, int(floor(qMax(p[0].y(), qMax(p[1].y(), p[2].y())))));
+    if(minX > maxX || minY > maxY)
+        return;
+
+    float edges[9];
+    for(int i = 0; i < 3; i++)
+    {
+        const QPointF & p0 = p[i];
+        const QPointF & p1 = p[(i + 1) % 3];
+        const double A = p0.y() - p1.y();
+        const double B = p1.x() - p0.x();
+        edges[i * 3 + 0] = A;
+        edges[i * 3 + 1] = B;
+        edges[i * 3 + 2] = -(A * p0.x() + B * p0.y());
+    }
+
+    for(int ty = minY / TileSize * TileSize; ty <= maxY; ty += TileSize)
+    {
+        for(int tx = minX / TileSize * TileSize; tx <= maxX; tx += TileSize)
+        {
+            const float x0 = tx + 0.5f;
+            const float y0 = ty + 0.5f;
+            const float x1 = x0 + TileSize - 1;
+            const float y1 = y0 + TileSize - 1;
+
+            bool rejected = false;
+            bool accepted = true;
+            for(int i = 0; i < 3 && !rejected; i++)
+            {
+                const float * e = edges + i * 3;
+                const float e00 = e[0] * x0 + e[1] * y0 + e[2];
+                const float e10 = e[0] * x1 + e[1] * y0 + e[2];
+                const float e01 = e[0] * x0 + e[1] * y1 + e[2];
+                const float e11 = e[0] * x1 + e[1] * y1 + e[2];
+                rejected = qMax(qMax(e00, e10), qMax(e01, e11)) < 0.0f;
+                accepted = accepted && qMin(qMin(e00, e10), qMin(e01, e11)) >= 0.0f;
+            }
+
+            if(rejected)
+                continue;
+
+            if(accepted && myBitsRendered)
+            {
+                const quint64 bits = quint64(0xFF) << (tx % 64);
+                for(int y = 0; y < TileSize; y++)
+                    myBits[(ty + y) * myBitsStride + tx / 64] |= bits;
+            }
+            else if(accepted)
+            {
+                for(int y = 0; y < TileSize; y++)
+                    std::fill_n(myBuffer.data() + (ty + y) * myStride + tx, TileSize, value);
+            }
+            else
+                fillTile(tx, ty, edges, value);
+        }
+    }
+}
+
+/**
+ * @brief Fills the covered pixels of a partially covered tile
+ * @param[in] x0 Left column of the tile
+ * @param[in] y0 Bottom row of the tile
+ * @param[in] edges Coefficients A, B, C of the three edge functions
+ * @param[in] value Value of the covered pixels
+ *
+ * The covered pixels of a tile row form a single byte of the packed mask.
+ *
+ */
+void TSoftwareRenderer::fillTile(int x0, int y0, const float * edges, float value)
+{
+#ifdef TSOFTWARERENDERER_SSE2
+    const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 values = _mm_set1_ps(value);
+    const __m128 A0 = _mm_set1_ps(edges[0]);
+    const __m128 A1 = _mm_set1_ps(edges[3]);
+    const __m128 A2 = _mm_set1_ps(edges[6]);
+
+    for(int y = 0; y < TileSize; y++)
+    {
+        const float yc = y0 + y + 0.5f;
+        const __m128 R0 = _mm_set1_ps(edges[1] * yc + edges[2]);
+        const __m128 R1 = _mm_set1_ps(edges[4] * yc + edges[5]);
+        const __m128 R2 = _mm_set1_ps(edges[7] * yc + edges[8]);
+        int covered = 0;
+
+        for(int x = 0; x < TileSize; x += 4)
+        {
+            const __m128 xc = _mm_add_ps(_mm_set1_ps(float(x0 + x)), offsets);
+            __m128 mask = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(A0, xc), R0), zero);
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(A1, xc), R1), zero));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(A2, xc), R2), zero));
+
+            if(myBitsRendered)
+            {
+                covered |= _mm_movemask_ps(mask) << x;
+                continue;
+            }
+
+            float * row = myBuffer.data() + (y0 + y) * myStride + x0;
+            const __m128 old = _mm_loadu_ps(row + x);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, values), _mm_andnot_ps(mask, old)));
+        }
+
+        if(myBitsRendered)
+            myBits[(y0 + y) * myBitsStride + x0 / 64] |= quint64(covered) << (x0 % 64);
+    }
+#else
+    for(int y = 0; y < TileSize; y++)
+    {
+        const float yc = y0 + y + 0.5f;
+        int covered = 0;
+        for(int x = 0; x < TileSize; x++)
+        {
+            const float xc = x0 + x + 0.5f;
+            if(edges[0] * xc + edges[1] * yc + edges[2] >= 0.0f &&
+               edges[3] * xc + edges[4] * yc + edges[5] >= 0.0f &&
+               edges[6] * xc + edges[7] * yc + edges[8] >= 0.0f)
+                covered |= 1 << x;
+        }
+
+        if(myBitsRendered)
+            myBits[(y0 + y) * myBitsStride + x0 / 64] |= quint64(covered) << (x0 % 64);
+        else
+        {
+            float * row = myBuffer.data() + (y0 + y) * myStride + x0;
+            for(int x = 0; x < TileSize; x++)
+                if(covered & (1 << x))
+                    row[x] = value;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Rasterizes a line into the buffer
+ * @param[in] a First point in the buffer coordinates
+ * @param[in] b Second point in the buffer coordinates
+ * @param[in] value Value of the covered pixels
+ */
+void TSoftwareRenderer::rasterizeLine(const QPointF & a, const QPointF & b, float value)
+{
+    const QRect crop = getCropRect();
+    const QPointF d = b - a;
+    const int steps = qMax(1, int(ceil(qMax(qAbs(d.x()), qAbs(d.y())))));
+
+    for(int i = 0; i <= steps; i++)
+    {
+        const QPointF p = a + d * (double(i) / steps);
+        const int x = int(floor(p.x()));
+        const int y = int(floor(p.y()));
+        if(x < 0 || y < 0 || x >= crop.width() || y >= crop.height())
+            continue;
+
+        if(myBitsRendered)
+            myBits[y * myBitsStride + x / 64] |= quint64(1) << (x % 64);
+        else
+            myBuffer[y * myStride + x] = value;
+    }
+}
+
+/**
+ * @brief Renders the contour edges of the model
+ * @param[in] scene Vertices in the scene coordinates
+ * @param[in] points Vertices in the buffer coordinates
+ *
+ * The contour edges are the edges shared by a triangle facing the X-ray
+ * source and a triangle facing away, and the boundary edges of the mesh.
+ *
+ */
+void TSoftwareRenderer::renderSilhouettes(const QVector<QVector3D> & scene, const QVector<QPointF> & points)
+{
+    const QVector<QVector<unsigned int> > & triangles = myModel->getTriangles();
+    const QVector3D eye = myProjection.getEye();
+
+    QHash<quint64, bool> edges;
+    foreach(const QVector<unsigned int> & triangle, triangles)
+    {
+        const QVector3D & a = scene.at(triangle.at(0));
+        const QVector3D & b = scene.at(triangle.at(1));
+        const QVector3D & c = scene.at(triangle.at(2));
+        const bool front = QVector3D::dotProduct(QVector3D::crossProduct(b - a, c - a), a - eye) < 0.0f;
+
+        for(int i = 0; i < 3; i++)
+        {
+            const quint64 v0 = qMin(triangle.at(i), triangle.at((i + 1) % 3));
+            const quint64 v1 = qMax(triangle.at(i), triangle.at((i + 1) % 3));
+            const quint64 key = (v0 << 32) | v1;
+
+            QHash<quint64, bool>::iterator it = edges.find(key);
+            if(it == edges.end())
+                edges.insert(key, front);
+            else
+            {
+                if(it.value() != front)
+                    rasterizeLine(points.at(int(v0)), points.at(int(v1)), 1.0f);
+                edges.erase(it);
+            }
+        }
+    }
+
+    for(QHash<quint64, bool>::const_iterator it = edges.constBegin(); it != edges.constEnd(); ++it)
+        rasterizeLine(points.at(int(it.key() >> 32)), points.at(int(it.key() & 0xFFFFFFFF)), 1.0f);
+}
+
+/**
+ * @brief Renders the digitally reconstructed radiograph
+ * @param[in] scene Vertices in the scene coordinates
+ * @param[in] points Vertices in the buffer coordinates
+ *
+ * The pixel value is 1 - exp(-intensity * L), L is the integral of the
+ * density along the ray of the pixel.
+ *
+ */
+void TSoftwareRenderer::renderDensity(const QVector<QVector3D> & scene, const QVector<QPointF> & points)
+{
+    const QRect crop = getCropRect();
+    const QVector<QVector<unsigned int> > & tetrahedra = myModel->getTetrahedra();
+    const QVector<float> & densities = myModel->getDensities();
+    if(densities.size() != tetrahedra.size())
+        return;
+
+    // Ray of the buffer pixel (x, y) is ray + (x + 0.5) * column - (y + 0.5) * row
+    const QVector3D eye    = myProjection.getEye();
+    const QVector3D column = myProjection.getColumn();
+    const QVector3D row    = myProjection.getRow();
+    const QVector3D ray    = myProjection.getLeftTop() - eye + crop.left() * column + (crop.top() + crop.height()) * row;
+
+    QVector<TTetrahedron> prepared;
+    prepared.reserve(tetrahedra.size());
+    for(int i = 0; i < tetrahedra.size(); i++)
+    {
+        const QVector<unsigned int> & tetrahedron = tetrahedra.at(i);
+        if(densities.at(i) == 0.0f)
+            continue;
+
+        TTetrahedron t;
+        double minX = points.at(tetrahedron.at(0)).x(), maxX = minX;
+        double minY = points.at(tetrahedron.at(0)).y(), maxY = minY;
+        for(int j = 1; j < 4; j++)
+        {
+            const QPointF & p = points.at(tetrahedron.at(j));
+            minX = qMin(minX, p.x());
+            maxX = qMax(maxX, p.x());
+            minY = qMin(minY, p.y());
+            maxY = qMax(maxY, p.y());
+        }
+        t.minX = qMax(0, int(floor(minX)));
+        t.minY = qMax(0, int(floor(minY)));
+        t.maxX = qMin(crop.width()  - 1, int(floor(maxX)));
+        t.maxY = qMin(crop.height() - 1, int(floor(maxY)));
+        if(t.minX > t.maxX || t.minY > t.maxY)
+            continue;
+
+        for(int j = 0; j < 4; j++)
+        {
+            // Face opposite to the vertex j, the normal points out of the tetrahedron
+            const QVector3D & q  = scene.at(tetrahedron.at((j + 1) % 4));
+            const QVector3D & q1 = scene.at(tetrahedron.at((j + 2) % 4));
+            const QVector3D & q2 = scene.at(tetrahedron.at((j + 3) % 4));
+            QVector3D n = QVector3D::crossProduct(q1 - q, q2 - q);
+            if(QVector3D::dotProduct(n, scene.at(tetrahedron.at(j)) - q) > 0.0f)
+                n = -n;
+
+            t.a[j]  = QVector3D::dotProduct(n, eye - q);
+            t.bx[j] = QVector3D::dotProduct(n, column);
+            t.by[j] = -QVector3D::dotProduct(n, row);
+            t.b[j]  = QVector3D::dotProduct(n, ray) + 0.5f * t.bx[j] + 0.5f * t.by[j];
+        }
+        t.density = densities.at(i);
+        prepared.append(t);
+    }
+
+    myRayLengths.resize(myBuffer.size());
+
+    const int first = myBounds.top();
+    const int height = qMin(crop.height() - 1, myBounds.bottom()) - first + 1;
+    if(height <= 0)
+        return;
+
+    TWorkerPool * pool = myRoot->myWorkerPool;
+    int bands = pool != NULL ? pool->size() : 1;
+    if(height < bands)
+        bands = 1;
+
+    // Each band integrates only the tetrahedra overlapping its rows, the band
+    // of the row first + r is the last band i with height * i / bands <= r
+    QVector<QVector<int> > binned(bands);
+    for(int k = 0; k < prepared.size(); k++)
+    {
+        const int r0 = qBound(0, prepared.at(k).minY - first, height - 1);
+        const int r1 = qBound(0, prepared.at(k).maxY - first, height - 1);
+        const int last = int(((qint64(r1) + 1) * bands - 1) / height);
+        for(int i = int(((qint64(r0) + 1) * bands - 1) / height); i <= last; i++)
+            binned[i].append(k);
+    }
+
+    if(bands == 1)
+    {
+        integrateBand(first, first + height - 1, ray, prepared, binned.at(0));
+        return;
+    }
+
+    pool->run(bands, [this, first, height, bands, ray, &prepared, &binned](int i) {
+        const int y0 = first + height * i / bands;
+        const int y1 = first + height * (i + 1) / bands - 1;
+        integrateBand(y0, y1, ray, prepared, binned.at(i));
+    });
+}
+
+/**
+ * @brief Integrates the density along the rays of a band of rows
+ * @param[in] y0 First row of the band
+ * @param[in] y1 Last row of the band
+ * @param[in] ray Ray of the buffer pixel (-0.5, -0.5)
+ * @param[in] tetrahedra Tetrahedra prepared for the integration
+ * @param[in] indices Indices of the tetrahedra overlapping the rows of the band
+ */
+void TSoftwareRenderer::integrateBand(int y0, int y1, const QVector3D & ray,
+                                      const QVector<TTetrahedron> & tetrahedra, const QVector<int> & indices)
+{
+    const QRect crop = getCropRect();
+    const QVector3D column = myProjection.getColumn();
+    const QVector3D row    = myProjection.getRow();
+    float * buffer  = myBuffer.data();
+    float * lengths = myRayLengths.data();
+
+    for(int y = y0; y <= y1; y++)
+        for(int x = myBounds.left(); x <= myBounds.right(); x++)
+            lengths[y * myStride + x] = (ray + (x + 0.5f) * column - (y + 0.5f) * row).length();
+
+    foreach(int k, indices)
+    {
+        const TTetrahedron & t = tetrahedra.at(k);
+        const int minY = qMax(y0, t.minY);
+        const int maxY = qMin(y1, t.maxY);
+
+        for(int y = minY; y <= maxY; y++)
+        {
+#ifdef TSOFTWARERENDERER_SSE2
+            const __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 infinity = _mm_set1_ps(1e30f);
+            const __m128 density = _mm_set1_ps(t.density);
+
+            for(int x = t.minX & ~3; x <= t.maxX; x += 4)
+            {
+                const __m128 xc = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+                __m128 enter = zero;
+                __m128 exit  = infinity;
+                for(int j = 0; j < 4; j++)
+                {
+                    const __m128 b = _mm_add_ps(_mm_set1_ps(t.b[j] + y * t.by[j]), _mm_mul_ps(_mm_set1_ps(t.bx[j]), xc));
+                    const __m128 r = _mm_div_ps(_mm_set1_ps(-t.a[j]), b);
+                    const __m128 in  = _mm_cmplt_ps(b, zero);
+                    const __m128 out = _mm_cmpgt_ps(b, zero);
+                    enter = _mm_max_ps(enter, _mm_and_ps(in, r));
+                    exit  = _mm_min_ps(exit, _mm_or_ps(_mm_and_ps(out, r), _mm_andnot_ps(out, infinity)));
+
+                    // Ray parallel to the face misses the tetrahedron if it starts outside of the face
+                    if(t.a[j] > 0.0f)
+                        exit = _mm_andnot_ps(_mm_cmpeq_ps(b, zero), exit);
+                }
+
+                const int i = y * myStride + x;
+                const __m128 chord = _mm_mul_ps(_mm_max_ps(zero, _mm_sub_ps(exit, enter)), _mm_loadu_ps(lengths + i));
+                _mm_storeu_ps(buffer + i, _mm_add_ps(_mm_loadu_ps(buffer + i), _mm_mul_ps(density, chord)));
+            }
+#else
+            for(int x = t.minX; x <= t.maxX; x++)
+            {
+                float enter = 0.0f;
+                float exit  = 1e30f;
+                for(int j = 0; j < 4; j++)
+                {
+                    const float b = t.b[j] + y * t.by[j] + x * t.bx[j];
+                    if(b < 0.0f)
+                        enter = qMax(enter, -t.a[j] / b);
+                    else if(b > 0.0f)
+                        exit = qMin(exit, -t.a[j] / b);
+                    else if(t.a[j] > 0.0f)
+                        exit = 0.0f; // Ray parallel to the face misses the tetrahedron if it starts outside of the face
+                }
+
+                const int i = y * myStride + x;
+                buffer[i] += t.density * qMax(0.0f, exit - enter) * lengths[i];
+            }
+#endif
+        }
+    }
+
+    const int right = qMin(crop.width() - 1, myBounds.right());
+    for(int y = y0; y <= y1; y++)
+        for(int x = myBounds.left(); x <= right; x++)
+            buffer[y * myStride + x] = 1.0f - exp(-myIntensity * buffer[y * myStride + x]);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file        tvertexbuffer.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TVertexBuffer class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+
+#include "Renderer/tvertexbuffer.h"
+
+#include <assert.h>
+#include <algorithm>
+
+/**
+ * @brief Constructor of TVertexBuffer class
+ * @param[in] renderer Renderer owning the shape of the fragment
+ */
+TVertexBuffer::TVertexBuffer(TRenderer * renderer):
+    myRenderer(renderer),
+    myVersion(0),
+    myValid(false)
+{
+    assert(renderer != NULL);
+}
+
+/**
+ * @brief Gets the vertices of the current shape
+ * @return Shared vector of x, y, z triplets in the model coordinates
+ */
+QVector<float> TVertexBuffer::getVertices()
+{
+    update();
+    return myVertices;
+}
+
+/**
+ * @brief Gets the number of vertices
+ * @return Number of vertices
+ */
+int TVertexBuffer::getNumberOfVertices()
+{
+    update();
+    return myVertices.size() / 3;
+}
+
+/**
+ * @brief Gets the shape version of the buffered vertices
+ * @return Shape version
+ */
+unsigned int TVertexBuffer::getVersion()
+{
+    update();
+    return myVersion;
+}
+
+/**
+ * @brief Recomputes the vertices if the shape has changed
+ */
+void TVertexBuffer::update()
+{
+    const unsigned int version = myRenderer->getShapeVersion();
+    if(myValid && version == myVersion)
+        return;
+
+    float * vertices = NULL;
+    const int nv = myRenderer->getRecomputedVertices(vertices);
+
+    // Detaches from the borrowed copies
+    myVertices.resize(nv * 3);
+    if(vertices != NULL)
+        std::copy(vertices, vertices + nv * 3, myVertices.begin());
+    delete[] vertices;
+
+    myVersion = version;
+    myValid = true;
+}
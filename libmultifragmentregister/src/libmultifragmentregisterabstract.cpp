@@ -18,6 +18,7 @@
  */
 
 #include "libmultifragmentregisterabstract.h"
+#include "timagereader.h"
 
 /**
  * @brief Loads float values from CSV file
@@ -78,17 +79,7 @@ printMatrix(const dlib::matrix<float> & g)
  */
 QImage LibMultiFragmentRegisterAbstract::maskImage(const QImage & image)
 {
-    QImage result(image.size(), QImage::Format_Indexed8); //image.format());
-    result.setColor(255, qRgb(255,255,255));
-    result.setColor(0, qRgb(0,0,0));
-    result.fill(0);
-
-    for(int x = 0; x < result.width(); x++)
-        for(int y = 0; y < result.height(); y++)
-            if(qRed(image.pixel(x, y)) > 10 || qGreen(image.pixel(x, y)) > 10 || qBlue(image.pixel(x, y)) > 10)
-                result.setPixel(x, y, 255);
-
-    return result;
+    return TImageReader::threshold(image, 10);
 }
 
 /**
@@ -99,45 +90,12 @@ QImage LibMultiFragmentRegisterAbstract::maskImage(const QImage & image)
 QRect LibMultiFragmentRegisterAbstract::
 cropImage(const QImage & image)
 {
-    int left = 0;
-    int right = 0;
-    int top = 0;
-    int bottom = 0;
-
-    QImage nimage = image.convertToFormat(QImage::Format_RGB888);
+    const QRect bounds = TImageReader::bounds(image, 10);
 
-    for(int x = 0; x < nimage.width(); x++)
-        for(int y = 0; y < nimage.height(); y++)
-            if(qRed(nimage.pixel(x, y)) > 10)
-            {
-                left = x;
-                goto next1;
-            }
-    next1:
-    for(int x = nimage.width() - 1; x >=0; x--)
-        for(int y = 0; y < nimage.height(); y++)
-            if(qRed(nimage.pixel(x, y)) > 10)
-            {
-                right = x;
-                goto next2;
-            }
-    next2:
-    for(int y = 0; y < nimage.height(); y++)
-        for(int x = 0; x < nimage.width(); x++)
-            if(qRed(nimage.pixel(x, y)) > 10)
-            {
-                top = y;
-                goto next3;
-            }
-    next3:
-    for(int y = nimage.height() - 1; y >=0; y--)
-        for(int x = 0; x < nimage.width(); x++)
-            if(qRed(nimage.pixel(x, y)) > 10)
-            {
-                bottom = y;
-                goto next4;
-            }
-    next4:
+    int left   = bounds.isNull() ? 0 : bounds.left();
+    int right  = bounds.isNull() ? 0 : bounds.right();
+    int top    = bounds.isNull() ? 0 : bounds.top();
+    int bottom = bounds.isNull() ? 0 : bounds.bottom();
 
     left -= 8;
     top -= 8;
@@ -147,8 +105,8 @@ cropImage(const QImage & image)
     if(left < 0) left = 0;
     if(top  < 0) top = 0;
 
-    if(right  > nimage.rect().right())  right  = nimage.rect().right();
-    if(bottom > nimage.rect().bottom()) bottom = nimage.rect().bottom();
+    if(right  > image.rect().right())  right  = image.rect().right();
+    if(bottom > image.rect().bottom()) bottom = image.rect().bottom();
 
     return QRect(QPoint(left, top), QPoint(right, bottom));
 }
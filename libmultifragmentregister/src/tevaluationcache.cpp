@@ -0,0 +1,130 @@
+/**
+ * @file        tevaluationcache.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TEvaluationCache class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "tevaluationcache.h"
+
+/**
+ * @brief Constructor of TEvaluationCache class
+ * @param[in] capacity Maximal number of stored evaluations
+ */
+TEvaluationCache::TEvaluationCache(int capacity):
+    myCapacity(capacity)
+{
+}
+
+/**
+ * @brief Removes all stored evaluations
+ */
+void TEvaluationCache::
+clear()
+{
+    myEntries.clear();
+}
+
+/**
+ * @brief Sets the maximal number of stored evaluations
+ * @param[in] capacity Number of evaluations, 0 disables the cache
+ */
+void TEvaluationCache::
+setCapacity(int capacity)
+{
+    myCapacity = capacity;
+    while(myEntries.size() > myCapacity)
+        myEntries.removeLast();
+}
+
+/**
+ * @brief Finds the evaluation of the given parameters
+ * @param[in] params Vector of parameters
+ * @return Pointer to the stored evaluation, null pointer if there is none
+ *
+ * The found entry becomes the most recently used one.
+ *
+ */
+TEvaluationCache::Entry * TEvaluationCache::
+find(const dlib::matrix<double, 0, 1> & params)
+{
+    for(QLinkedList<Entry>::iterator it = myEntries.begin(); it != myEntries.end(); ++it)
+    {
+        if(it->params.size() == params.size() && it->params == params)
+        {
+            if(it != myEntries.begin())
+            {
+                myEntries.prepend(*it);
+                myEntries.erase(it);
+            }
+            return &myEntries.first();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Gets the entry of the given parameters, a new empty entry is created if needed
+ * @param[in] params Vector of parameters
+ * @return Pointer to the entry, null pointer if the cache is disabled
+ */
+TEvaluationCache::Entry * TEvaluationCache::
+insert(const dlib::matrix<double, 0, 1> & params)
+{
+    if(myCapacity <= 0)
+        return NULL;
+
+    Entry * entry = find(params);
+    if(entry != NULL)
+        return entry;
+
+    if(myEntries.size() >= myCapacity)
+        myEntries.removeLast();
+
+    Entry e;
+    e.params = params;
+    e.hasValues = false;
+    e.hasJacobian = false;
+    myEntries.prepend(e);
+    return &myEntries.first();
+}
+
+/**
+ * @brief Stores the Jacobian matrix of the given parameters
+ * @param[in] params Vector of parameters
+ * @param[in] jacobian Jacobian matrix
+ *
+ * Jacobian matrices stored for other parameters are released.
+ *
+ */
+void TEvaluationCache::
+storeJacobian(const dlib::matrix<double, 0, 1> & params, const dlib::matrix<float> & jacobian)
+{
+    Entry * entry = insert(params);
+    if(entry == NULL)
+        return;
+
+    for(QLinkedList<Entry>::iterator it = myEntries.begin(); it != myEntries.end(); ++it)
+    {
+        if(it->hasJacobian)
+        {
+            it->jacobian.set_size(0, 0);
+            it->hasJacobian = false;
+        }
+    }
+
+    entry->jacobian = jacobian;
+    entry->hasJacobian = true;
+}
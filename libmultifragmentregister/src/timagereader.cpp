@@ -0,0 +1,242 @@
+/**
+ * @file        timagereader.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TImageReader class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "timagereader.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TIMAGEREADER_SSE2
+#endif
+
+/**
+ * @brief Converts the image to the format read by the functions
+ * @param[in] image Image of any format
+ * @return The same image if it already has 32 bits per pixel, converted copy otherwise
+ */
+QImage TImageReader::normalized(const QImage & image)
+{
+    if(image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32)
+        return image;
+
+    return image.convertToFormat(QImage::Format_RGB32);
+}
+
+/**
+ * @brief Reads the red channel of the image
+ * @param[in] image Image
+ * @param[out] data Buffer of width * height values, rows are stored bottom-up
+ *
+ * The values are scaled to the range 0 to 1.
+ *
+ */
+void TImageReader::readRed(const QImage & image, float * data)
+{
+    const QImage source = normalized(image);
+    const int w = source.width();
+    const int h = source.height();
+
+    for(int row = 0; row < h; row++)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(source.constScanLine(h - 1 - row));
+        float * values = data + row * w;
+
+        int col = 0;
+#ifdef TIMAGEREADER_SSE2
+        const __m128i red = _mm_set1_epi32(0xFF);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        for(; col + 4 <= w; col += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128((const __m128i *)(line + col));
+            const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), red);
+            _mm_storeu_ps(values + col, _mm_div_ps(_mm_cvtepi32_ps(r), scale));
+        }
+#endif
+        for(; col < w; col++)
+            values[col] = qRed(line[col]) / 255.0f;
+    }
+}
+
+/**
+ * @brief Thresholds the red channel of the image
+ * @param[in] image Image
+ * @param[in] threshold Maximal red value of the pixels not included in the mask
+ * @param[out] mask Buffer of width * height values, rows are stored bottom-up
+ */
+void TImageReader::readRedMask(const QImage & image, int threshold, bool * mask)
+{
+    const QImage source = normalized(image);
+    const int w = source.width();
+    const int h = source.height();
+
+    for(int row = 0; row < h; row++)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(source.constScanLine(h - 1 - row));
+        bool * values = mask + row * w;
+
+        int col = 0;
+#ifdef TIMAGEREADER_SSE2
+        const __m128i red = _mm_set1_epi32(0xFF);
+        const __m128i limit = _mm_set1_epi32(threshold);
+        for(; col + 4 <= w; col += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128((const __m128i *)(line + col));
+            const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), red);
+            const int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(r, limit)));
+            values[col + 0] = bits & 1;
+            values[col + 1] = bits & 2;
+            values[col + 2] = bits & 4;
+            values[col + 3] = bits & 8;
+        }
+#endif
+        for(; col < w; col++)
+            values[col] = qRed(line[col]) > threshold;
+    }
+}
+
+/**
+ * @brief Packs the thresholded red channel of the image
+ * @param[in] image Image
+ * @param[in] threshold Threshold of the red channel
+ * @param[in] above Packs the pixels with the red channel above the threshold if set, the other pixels otherwise
+ * @param[out] bits Packed mask of height * stride words cleared by the caller, rows are stored bottom-up
+ * @param[in] stride Number of words of a row, at least TRenderer::getBitsStride(width)
+ */
+void TImageReader::readRedBits(const QImage & image, int threshold, bool above, quint64 * bits, int stride)
+{
+    const QImage source = normalized(image);
+    const int w = source.width();
+    const int h = source.height();
+
+    for(int row = 0; row < h; row++)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(source.constScanLine(h - 1 - row));
+        quint64 * words = bits + row * stride;
+
+        int col = 0;
+#ifdef TIMAGEREADER_SSE2
+        // Four pixels never cross a word as the words start at multiples of four
+        const __m128i red = _mm_set1_epi32(0xFF);
+        const __m128i limit = _mm_set1_epi32(threshold);
+        for(; col + 4 <= w; col += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128((const __m128i *)(line + col));
+            const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), red);
+            int nibble = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(r, limit)));
+            if(!above)
+                nibble ^= 0xF;
+            words[col / 64] |= quint64(nibble) << (col % 64);
+        }
+#endif
+        for(; col < w; col++)
+            if((qRed(line[col]) > threshold) == above)
+                words[col / 64] |= quint64(1) << (col % 64);
+    }
+}
+
+/**
+ * @brief Creates a binary mask of the image
+ * @param[in] image Image
+ * @param[in] threshold Maximal value of each color channel of the pixels not included in the mask
+ * @return 8-bit indexed image, the included pixels are 255, the other pixels are 0
+ */
+QImage TImageReader::threshold(const QImage & image, int threshold)
+{
+    const QImage source = normalized(image);
+    const int w = source.width();
+    const int h = source.height();
+
+    QImage result(source.size(), QImage::Format_Indexed8);
+    result.setColor(255, qRgb(255,255,255));
+    result.setColor(0, qRgb(0,0,0));
+
+    for(int y = 0; y < h; y++)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+        uchar * values = result.scanLine(y);
+
+        int x = 0;
+#ifdef TIMAGEREADER_SSE2
+        // Bytes above the threshold stay non-zero after the saturated subtraction
+        const __m128i color = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i limit = _mm_set1_epi8(char(threshold));
+        const __m128i zero  = _mm_setzero_si128();
+        for(; x + 4 <= w; x += 4)
+        {
+            const __m128i pixels = _mm_and_si128(_mm_loadu_si128((const __m128i *)(line + x)), color);
+            const __m128i over = _mm_subs_epu8(pixels, limit);
+            const int empty = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(over, zero)));
+            values[x + 0] = (empty & 1) ? 0 : 255;
+            values[x + 1] = (empty & 2) ? 0 : 255;
+            values[x + 2] = (empty & 4) ? 0 : 255;
+            values[x + 3] = (empty & 8) ? 0 : 255;
+        }
+#endif
+        for(; x < w; x++)
+            values[x] = (qRed(line[x]) > threshold || qGreen(line[x]) > threshold || qBlue(line[x]) > threshold) ? 255 : 0;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Gets the bounding rectangle of the pixels with the red channel above the threshold
+ * @param[in] image Image
+ * @param[in] threshold Threshold of the red channel
+ * @return Bounding rectangle in the image coordinates, null rectangle if no pixel exceeds the threshold
+ *
+ * The image is read row by row, each row only up to its first and from its last pixel above the threshold.
+ *
+ */
+QRect TImageReader::bounds(const QImage & image, int threshold)
+{
+    const QImage source = normalized(image);
+    const int w = source.width();
+    const int h = source.height();
+
+    int left = w;
+    int right = -1;
+    int top = -1;
+    int bottom = -1;
+
+    for(int y = 0; y < h; y++)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+
+        int first = 0;
+        while(first < w && qRed(line[first]) <= threshold)
+            first++;
+        if(first == w)
+            continue;
+
+        int last = w - 1;
+        while(last > right && qRed(line[last]) <= threshold)
+            last--;
+
+        left  = qMin(left, first);
+        right = qMax(right, last);
+        if(top < 0)
+            top = y;
+        bottom = y;
+    }
+
+    if(top < 0)
+        return QRect();
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
@@ -0,0 +1,92 @@
+/**
+ * @file        tprojection.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TProjection class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "tprojection.h"
+
+/**
+ * @brief Default constructor of TProjection class
+ */
+TProjection::TProjection()
+{
+}
+
+/**
+ * @brief Constructor of TProjection class
+ * @param[in] perspective Perspective pyramid of the radiograph
+ * @param[in] size Size of the whole radiograph in pixels
+ *
+ * Solving eye + s * (point - eye) = leftTop + u * column + v * row
+ * by the Cramer's rule gives u and v as a ratio of two dot products
+ * with the vector (point - eye). The three vectors are precomputed here.
+ *
+ */
+TProjection::TProjection(const SSIMRenderer::Pyramid & perspective, const QSize & size):
+    myEye(perspective.getEye()),
+    myLeftTop(perspective.getLeftTop())
+{
+    myColumn = (perspective.getRightTop()   - myLeftTop) / size.width();
+    myRow    = (perspective.getLeftBottom() - myLeftTop) / size.height();
+
+    const QVector3D o = myEye - myLeftTop;
+    myU = QVector3D::crossProduct(o, myRow);
+    myV = QVector3D::crossProduct(myColumn, o);
+    myW = QVector3D::crossProduct(myColumn, myRow);
+}
+
+/**
+ * @brief Projects the scene point onto the radiograph
+ * @param[in] point Point in the scene coordinates
+ * @return Continuous pixel coordinates of the projected point
+ */
+QPointF TProjection::
+project(const QVector3D & point) const
+{
+    const QVector3D d = point - myEye;
+    const float w = QVector3D::dotProduct(myW, d);
+    return QPointF(QVector3D::dotProduct(myU, d) / w,
+                   QVector3D::dotProduct(myV, d) / w);
+}
+
+/**
+ * @brief Gets the projection as a matrix
+ * @return Matrix mapping the scene point to homogeneous pixel coordinates (u * w, v * w, 0, w)
+ */
+QMatrix4x4 TProjection::
+getMatrix() const
+{
+    return QMatrix4x4(myU.x(), myU.y(), myU.z(), -QVector3D::dotProduct(myU, myEye),
+                      myV.x(), myV.y(), myV.z(), -QVector3D::dotProduct(myV, myEye),
+                      0.0f,    0.0f,    0.0f,    0.0f,
+                      myW.x(), myW.y(), myW.z(), -QVector3D::dotProduct(myW, myEye));
+}
+
+/**
+ * @brief Intersects the ray of the given pixel with a plane facing the X-ray source
+ * @param[in] pixel Continuous pixel coordinates
+ * @param[in] planePoint Point of the plane, the plane is perpendicular to the ray passing this point
+ * @return Intersection in the scene coordinates
+ */
+QVector3D TProjection::
+backProject(const QPointF & pixel, const QVector3D & planePoint) const
+{
+    const QVector3D normal = planePoint - myEye;
+    const QVector3D ray = myLeftTop + pixel.x() * myColumn + pixel.y() * myRow - myEye;
+    const float t = QVector3D::dotProduct(normal, normal) / QVector3D::dotProduct(normal, ray);
+    return myEye + t * ray;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file        tscenesnapshot.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TSceneSnapshot class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "tscenesnapshot.h"
+
+#include <assert.h>
+
+/**
+ * @brief Default constructor of TSceneSnapshot class
+ */
+TSceneSnapshot::TSceneSnapshot():
+    sampleIteration(0)
+{
+}
+
+/**
+ * @brief Constructor of TSceneSnapshot class
+ * @param[in] rotations Rotation of each fragment
+ * @param[in] translations Translation of each fragment
+ * @param[in] shape Standardized shape parameters
+ * @param[in] sampleIteration Iteration of the pixel subset
+ */
+TSceneSnapshot::TSceneSnapshot(const QVector<QVector3D> & rotations,
+                               const QVector<QVector3D> & translations,
+                               const QVector<float> & shape,
+                               unsigned int sampleIteration):
+    rotations(rotations),
+    translations(translations),
+    shape(shape),
+    sampleIteration(sampleIteration)
+{
+    assert(rotations.size() == translations.size());
+}
+
+/**
+ * @brief Creates a copy of the snapshot with the parameters of the optimization
+ * @param[in] params Six pose parameters of each fragment optionally followed by the leading shape parameters
+ * @return New snapshot, the parameters not contained in the vector are kept
+ */
+TSceneSnapshot TSceneSnapshot::withParams(const dlib::matrix<double, 0, 1> & params) const
+{
+    const int poses = 6 * rotations.size();
+    assert(params.size() >= poses && params.size() <= poses + shape.size());
+
+    TSceneSnapshot result(*this);
+    for(int f = 0; f < rotations.size(); f++)
+    {
+        result.rotations[f]    = QVector3D(params(6 * f + 0), params(6 * f + 1), params(6 * f + 2));
+        result.translations[f] = QVector3D(params(6 * f + 3), params(6 * f + 4), params(6 * f + 5));
+    }
+
+    for(int i = 0; i < params.size() - poses; i++)
+        result.shape[i] = params(poses + i);
+
+    return result;
+}
+
+/**
+ * @brief Gets the parameters of the optimization
+ * @param[in] shapeCount Number of the leading shape parameters appended after the poses
+ * @return Six pose parameters of each fragment followed by the shape parameters
+ */
+dlib::matrix<double, 0, 1> TSceneSnapshot::toParams(unsigned int shapeCount) const
+{
+    const int poses = 6 * rotations.size();
+    assert(int(shapeCount) <= shape.size());
+
+    dlib::matrix<double, 0, 1> result(poses + shapeCount);
+    for(int f = 0; f < rotations.size(); f++)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            result(6 * f + i)     = rotations.at(f)[i];
+            result(6 * f + 3 + i) = translations.at(f)[i];
+        }
+    }
+
+    for(unsigned int i = 0; i < shapeCount; i++)
+        result(poses + i) = shape.at(i);
+
+    return result;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file        tstopcriteria.cpp
+ * @author      Ondrej Klima, BUT FIT Brno, iklima@fit.vutbr.cz
+ * @version     1.0
+ * @date        15 December 2016
+ *
+ * @brief       The implementation file containing the TStopCriteria class.
+ *
+ * @copyright   Copyright (C) 2016 Ondrej Klima, Petr Kleparnik. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "tstopcriteria.h"
+
+/**
+ * @brief Default constructor of TStopCriteria class
+ *
+ * The optimization stops when the objective changes by less than 1e-7
+ * or after 150 iterations.
+ *
+ */
+TStopCriteria::TStopCriteria():
+    minDelta(1e-7),
+    minRelativeDelta(0),
+    minStepNorm(0),
+    minGradientNorm(0),
+    maxIterations(150),
+    maxSeconds(0)
+{
+}
+
+/**
+ * @brief Constructor of TStopCriteria class
+ * @param[in] minDelta Minimal absolute change of the objective
+ * @param[in] maxIterations Maximal number of iterations
+ */
+TStopCriteria::TStopCriteria(double minDelta, unsigned long maxIterations):
+    minDelta(minDelta),
+    minRelativeDelta(0),
+    minStepNorm(0),
+    minGradientNorm(0),
+    maxIterations(maxIterations),
+    maxSeconds(0)
+{
+}
@@ -27,6 +27,7 @@
 #include <QPoint>
 
 #include "ssimrenderer.h"
+#include "tstopcriteria.h"
 
 /**
  * @brief The xmlparser class
@@ -64,11 +65,27 @@ public:
     bool manualInit;
     bool refLength;
     bool length;
+    bool imageGradient;
+    bool bitMask;
+    int broyden;
+    int samples;
+    int levels;
+    int starts;
+    double startRotation;
+    double startTranslation;
+    int startIterations;
+    unsigned int seed;
+    bool checkBackend;
+
+    QVector<TStopCriteria> stopCriteria;
     int views;
     int fragments;    
+    int threads;
 
     QString method;
     QString algorithm;
+    QString sampling;
+    QString backend;
     QString path;
     QString imagesPath;
     QString measurementFile;
@@ -83,6 +100,7 @@ public:
 
 private:
     bool read(QIODevice *device);
+    void readStopCriteria(const QString & name, const QString & value);
 
     QString shapeModel;
     QString densityModel;
@@ -30,6 +30,7 @@
 #include "ImageMetric/topenglsquareddifferencesmetric.h"
 #include "ImageMetric/tcpunormalizedmutualinformationmetric.h"
 #include "ImageMetric/tcpusquareddifferencesmetric.h"
+#include "ImageMetric/tbinarymetric.h"
 #include "ImageMetric/tsimplemetric.h"
 #include "ImageMetric/tsimplemetricmask.h"
 
@@ -103,20 +104,40 @@ int main(int argc, char *argv[])
     typedef LibMultiFragmentRegister<TSimpleMetricMask> SimpleRegistrationMask;
     typedef LibMultiFragmentRegister<TOpenGLNormalizedMutualInformationMetric> OpenGLNmiRegistration;
     typedef LibMultiFragmentRegister<TOpenGLSquaredDifferencesMetric> OpenGLSsdRegistration;
+    typedef LibMultiFragmentRegister<TCPUNormalizedMutualInformationMetric> CpuNmiRegistration;
+    typedef LibMultiFragmentRegister<TBinaryMetric> BinaryRegistration;
 
-    if(parser.method == "BW-PD")
+    const TRenderer::Backend backend = parser.backend == "software" ? TRenderer::SoftwareBackend : TRenderer::OpenGLBackend;
+    if(backend == TRenderer::SoftwareBackend && parser.method == "BW-SSD" && !parser.bitMask)
+        qDebug() << "WARNING: Method" << parser.method << "requires the OpenGL backend, the OpenGL backend is used.";
+
+    if(parser.bitMask && (parser.method == "BW-PD" || parser.method == "BW-PD-msk"))
+    {
+        registration = BinaryRegistration::New(parser.fragments, parser.views, new TSimpleVertexMetric, backend);
+    }
+    else if(parser.bitMask && parser.method == "BW-SSD")
+    {
+        registration = BinaryRegistration::New(parser.fragments, parser.views, new TSquaredDifferencesVertexMetric, backend);
+        registration->enableDensity(false);
+    }
+    else if(parser.method == "BW-PD")
     {
-        registration = SimpleRegistration::New(parser.fragments, parser.views, new TSimpleVertexMetric);
+        registration = SimpleRegistration::New(parser.fragments, parser.views, new TSimpleVertexMetric, backend);
     }
     else if(parser.method == "BW-PD-msk")
     {
-        registration = SimpleRegistrationMask::New(parser.fragments, parser.views, new TSimpleVertexMetric);
+        registration = SimpleRegistrationMask::New(parser.fragments, parser.views, new TSimpleVertexMetric, backend);
     }
     else if(parser.method == "BW-SSD")
     {
         registration = OpenGLSsdRegistration::New(parser.fragments, parser.views, new TSquaredDifferencesVertexMetric);
         registration->enableDensity(false);
     }
+    else if(backend == TRenderer::SoftwareBackend)
+    {
+        registration = CpuNmiRegistration::New(parser.fragments, parser.views, new TSimpleVertexMetric, backend);
+        registration->enableDensity(true);
+    }
     else
     {
         registration = OpenGLNmiRegistration::New(parser.fragments, parser.views, new TSimpleVertexMetric);
@@ -319,6 +340,12 @@ int main(int argc, char *argv[])
         registration->setTranslations(parser.translation);
     }
 
+    // Debugging aid, opt-in by checkBackend="1": compares the software renders
+    // with the OpenGL ones, which needs an OpenGL context the software backend
+    // otherwise does not
+    if(backend == TRenderer::SoftwareBackend && parser.checkBackend)
+        registration->compareBackends(TRenderer::OpenGLBackend);
+
     TDefaultObserver * observer = new TDefaultObserver;
     observer->setVerbose(parser.verbose);
     observer->enableImages(parser.saveImages);
@@ -326,34 +353,35 @@ int main(int argc, char *argv[])
     observer->setRefImages(images);
     observer->setWholeBones(true);
     registration->setObserver(observer);
+    registration->setThreadsCount(parser.threads);
+    registration->enableImagePoseGradient(parser.imageGradient);
+    if(parser.broyden > 0)
+        registration->enableBroydenUpdates(true, parser.broyden);
+    if(parser.samples > 0)
+    {
+        TImageMetric::SamplingType sampling = TImageMetric::RandomSampling;
+        if(parser.sampling == "stratified")
+            sampling = TImageMetric::StratifiedSampling;
+        else if(parser.sampling == "halton")
+            sampling = TImageMetric::HaltonSampling;
+        registration->setPixelSampling(sampling, parser.samples, parser.seed);
+    }
+
+    // Coarse to fine, the last stage at the full resolution
+    registration->optimizeMultiResolution(parser.levels, parser.fragments > 1 && parser.vertexMetric,
+                                          parser.stopCriteria, parser.starts, parser.startRotation,
+                                          parser.startTranslation, parser.startIterations, parser.seed);
 
+    // Renders and iterations of the three stages, the first one includes everything before
     QVector<int> imageCount(3, 0);
     QVector<int> iterationCount(3, 0);
-
-    registration->optimizePose();
-
-    imageCount[0]     = observer->getRenderedCount();
-    iterationCount[0] = observer->getIterations();
-
-    if(parser.fragments > 1 && parser.vertexMetric)
+    const QList<int> & renderedCounts = observer->getRegistrationRenderedCounts();
+    const QList<int> & iterations     = observer->getRegistrationIterations();
+    const int first = renderedCounts.size() - 3;
+    for(int i = 0; i < 3 && first >= 0; i++)
     {
-        registration->optimizePoseShapeVertex(5);
-        imageCount[1]     = observer->getRenderedCount() - imageCount[0];
-        iterationCount[1] = observer->getIterations() - iterationCount[0];
-
-        registration->optimizePoseShapeVertex();
-        imageCount[2]     = observer->getRenderedCount()  - imageCount[0] - imageCount[1];
-        iterationCount[2] = observer->getIterations() - iterationCount[0] - iterationCount[1];
-    }
-    else
-    {
-        registration->optimizePoseShape(5);
-        imageCount[1]     = observer->getRenderedCount() - imageCount[0];
-        iterationCount[1] = observer->getIterations() - iterationCount[0];
-
-        registration->optimizePoseShape();
-        imageCount[2]     = observer->getRenderedCount()  - imageCount[0] - imageCount[1];
-        iterationCount[2] = observer->getIterations() - iterationCount[0] - iterationCount[1];
+        imageCount[i]     = renderedCounts.at(first + i) - (i > 0 ? renderedCounts.at(first + i - 1) : 0);
+        iterationCount[i] = iterations.at(first + i)     - (i > 0 ? iterations.at(first + i - 1)     : 0);
     }
 
 
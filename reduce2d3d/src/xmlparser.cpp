@@ -45,6 +45,19 @@ xmlparser::xmlparser(QString mpath, QString filename):
     hausdorff = false;
     length = false;
     refLength = false;
+    threads = 0;
+    imageGradient = false;
+    bitMask = false;
+    broyden = 0;
+    samples = 0;
+    levels = 1;
+    starts = 1;
+    startRotation = 5;
+    startTranslation = 5;
+    startIterations = 5;
+    seed = 0;
+    checkBackend = false;
+    stopCriteria.resize(3);
     read(&file);
     file.close();
 }
@@ -104,6 +117,54 @@ QString xmlparser::posesFileName() const
     return poseFile;
 }
 
+/**
+ * @brief xmlparser::readStopCriteria Reads a convergence criterion of the registration stages
+ * @param name Attribute name
+ * @param value Comma separated values for the pose, rough shape and shape stages,
+ *              the last value is used for the remaining stages
+ *
+ * Negative or non-numeric values and a maximal number of iterations which
+ * is not a non-negative integer are errors.
+ */
+void xmlparser::readStopCriteria(const QString & name, const QString & value)
+{
+    const QStringList list = value.split(",", QString::SkipEmptyParts);
+    if(list.isEmpty())
+        return;
+
+    for(int i = 0; i < stopCriteria.size(); i++)
+    {
+        const QString item = list.at(qMin(i, list.size() - 1)).trimmed();
+
+        bool ok = false;
+        if (name == "maxIterations") {
+            const unsigned long n = item.toULong(&ok);
+            if(!ok)
+                throw std::runtime_error(std::string("Error reading XML file: maxIterations \"") + item.toStdString() +
+                                         "\" is not a non-negative integer.");
+            stopCriteria[i].maxIterations = n;
+            continue;
+        }
+
+        const double v = item.toDouble(&ok);
+        if(!ok || v < 0)
+            throw std::runtime_error(std::string("Error reading XML file: ") + name.toStdString() + " \"" +
+                                     item.toStdString() + "\" is not a non-negative number.");
+
+        if (name == "minDelta") {
+            stopCriteria[i].minDelta = v;
+        } else if (name == "minRelativeDelta") {
+            stopCriteria[i].minRelativeDelta = v;
+        } else if (name == "minStep") {
+            stopCriteria[i].minStepNorm = v;
+        } else if (name == "minGradient") {
+            stopCriteria[i].minGradientNorm = v;
+        } else if (name == "timeBudget") {
+            stopCriteria[i].maxSeconds = v;
+        }
+    }
+}
+
 /**
  * @brief xmlparser::read Parses the input XML file
  * @param device Opened handle to the XML file
@@ -155,6 +216,44 @@ bool xmlparser::read(QIODevice *device)
                      length = attr.value().toInt() == 1;
                 } else if (attr.name().toString() == "refLength") {
                      refLength = attr.value().toInt() == 1;
+                } else if (attr.name().toString() == "threads") {
+                     threads = attr.value().toInt();
+                } else if (attr.name().toString() == "imageGradient") {
+                     imageGradient = attr.value().toInt() == 1;
+                } else if (attr.name().toString() == "bitMask") {
+                     bitMask = attr.value().toInt() == 1;
+                } else if (attr.name().toString() == "broyden") {
+                     broyden = attr.value().toInt();
+                } else if (attr.name().toString() == "sampling") {
+                     sampling = attr.value().toString();
+                } else if (attr.name().toString() == "samples") {
+                     samples = attr.value().toInt();
+                } else if (attr.name().toString() == "levels") {
+                     bool ok = false;
+                     levels = attr.value().toInt(&ok);
+                     if(!ok || levels < 1)
+                         throw std::runtime_error(std::string("Error reading XML file: levels \"") +
+                                                  attr.value().toString().toStdString() + "\" is not a positive integer.");
+                } else if (attr.name().toString() == "backend") {
+                     backend = attr.value().toString();
+                } else if (attr.name().toString() == "checkBackend") {
+                     checkBackend = attr.value().toInt() == 1;
+                } else if (attr.name().toString() == "starts") {
+                     starts = attr.value().toInt();
+                } else if (attr.name().toString() == "startRotation") {
+                     startRotation = attr.value().toDouble();
+                } else if (attr.name().toString() == "startTranslation") {
+                     startTranslation = attr.value().toDouble();
+                } else if (attr.name().toString() == "startIterations") {
+                     startIterations = attr.value().toInt();
+                } else if (attr.name().toString() == "seed") {
+                     seed = attr.value().toUInt();
+                } else if (attr.name().toString() == "minDelta"    || attr.name().toString() == "minRelativeDelta" ||
+                           attr.name().toString() == "minStep"     || attr.name().toString() == "minGradient" ||
+                           attr.name().toString() == "maxIterations" || attr.name().toString() == "timeBudget") {
+                     readStopCriteria(attr.name().toString(), attr.value().toString());
+                } else {
+                     qDebug() << "WARNING: Unknown attribute" << attr.name().toString() << "is ignored.";
                 }
             }
             rotation.resize(fragments);